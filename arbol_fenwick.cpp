@@ -0,0 +1,81 @@
+#include "arbol_fenwick.h"
+#include "lib.h"
+
+using namespace std;
+
+namespace {
+
+size_t bit_menos_significativo(size_t i) {
+  return i & (~i + 1);
+}
+
+}
+
+ArbolFenwick::ArbolFenwick(size_t* bytes)
+  : _arbol(1, 0, AsignadorContado<double>(bytes)) {
+}
+
+ArbolFenwick::ArbolFenwick(const vector<double>& valores, size_t* bytes)
+  : _arbol(valores.size() + 1, 0, AsignadorContado<double>(bytes)) {
+  // Cada nodo le pasa su suma a su padre en el camino de actualización: al
+  // llegar a un nodo, todos sus hijos ya le sumaron.
+  for (size_t i = 1; i <= valores.size(); i++) { // O(n) iteraciones
+    _arbol[i] += valores[i - 1]; // O(1)
+    size_t padre = i + bit_menos_significativo(i); // O(1)
+    if (padre <= valores.size()) {
+      _arbol[padre] += _arbol[i]; // O(1)
+    }
+  }
+}
+
+size_t ArbolFenwick::tamano() const {
+  return _arbol.size() - 1;
+}
+
+void ArbolFenwick::extender(size_t tamano) {
+  size_t anterior = this->tamano();
+  if (tamano <= anterior) {
+    return;
+  }
+
+  _arbol.resize(tamano + 1, 0); // O(G) amortizado
+
+  // Los únicos nodos nuevos que cubren posiciones viejas (y por lo tanto no
+  // valen 0) son los que también cubren a la última posición vieja, es
+  // decir, los que están en su camino de actualización.
+  if (anterior == 0) {
+    return;
+  }
+
+  double total = _suma_primeras(anterior); // O(log n)
+  for (size_t i = anterior + bit_menos_significativo(anterior); i <= tamano; i += bit_menos_significativo(i)) { // O(log n) iteraciones
+    _arbol[i] = total - _suma_primeras(i - bit_menos_significativo(i)); // O(log n)
+  }
+}
+
+void ArbolFenwick::sumar(size_t posicion, double valor) {
+  for (size_t i = posicion + 1; i < _arbol.size(); i += bit_menos_significativo(i)) { // O(log n) iteraciones
+    _arbol[i] += valor; // O(1)
+  }
+}
+
+double ArbolFenwick::prefijo(size_t posicion) const {
+  return _suma_primeras(posicion + 1);
+}
+
+void ArbolFenwick::anticipar_prefijo(size_t posicion) const {
+  for (size_t i = posicion + 1; i > 0; i -= bit_menos_significativo(i)) { // O(log n) iteraciones
+    anticipar_lectura(&_arbol[i]); // O(1)
+  }
+}
+
+
+/** Métodos privados auxiliares */
+
+double ArbolFenwick::_suma_primeras(size_t cantidad) const {
+  double ret = 0;
+  for (size_t i = cantidad; i > 0; i -= bit_menos_significativo(i)) { // O(log n) iteraciones
+    ret += _arbol[i]; // O(1)
+  }
+  return ret;
+}
@@ -0,0 +1,80 @@
+#ifndef ARBOL_FENWICK_H
+#define ARBOL_FENWICK_H
+
+#include <vector>
+
+#include "memoria.h"
+
+using namespace std;
+
+/**
+ * Árbol de Fenwick (binary indexed tree) sobre las posiciones [0, n).
+ *
+ * Permite sumar un valor en cualquier posición y consultar la suma de un
+ * prefijo en O(log(n)), y agrandarse agregando posiciones en 0 al final.
+ *
+ * INVARIANTE DE REPRESENTACIÓN:
+ *  - `_arbol[0]` no se usa.
+ *  - Para todo 1 <= i <= n, `_arbol[i]` es la suma de los valores de las
+ *    posiciones [i - lsb(i), i), donde lsb(i) es el bit menos significativo
+ *    encendido de i.
+ */
+class ArbolFenwick {
+  public:
+    /**
+     * Constructor. Crea un árbol sin posiciones. Si se pasa `bytes`, ahí se
+     * lleva la cuenta de la memoria que ocupa el árbol.
+     */
+    explicit ArbolFenwick(size_t* bytes = nullptr);
+
+    /**
+     * Constructor. Crea un árbol con una posición por cada elemento de
+     * `valores`.
+     *
+     * Complejidad: O(n)
+     */
+    explicit ArbolFenwick(const vector<double>& valores, size_t* bytes = nullptr);
+
+    /** Cantidad de posiciones. */
+    size_t tamano() const;
+
+    /**
+     * Agrega posiciones en 0 al final hasta tener `tamano` posiciones. Si ya
+     * tiene al menos esa cantidad, no hace nada.
+     *
+     * Complejidad: O(G + log²(n)) amortizado, donde G es la cantidad de
+     * posiciones agregadas.
+     */
+    void extender(size_t tamano);
+
+    /**
+     * Suma `valor` en la posición `posicion`. Precondición: posicion < tamano().
+     *
+     * Complejidad: O(log(n))
+     */
+    void sumar(size_t posicion, double valor);
+
+    /**
+     * Suma de los valores de las posiciones [0, posicion]. Precondición:
+     * posicion < tamano().
+     *
+     * Complejidad: O(log(n))
+     */
+    double prefijo(size_t posicion) const;
+
+    /**
+     * Pide a la caché los nodos que lee `prefijo(posicion)`, sin esperar a
+     * que lleguen. Sirve para solapar la consulta de varios árboles.
+     *
+     * Complejidad: O(log(n))
+     */
+    void anticipar_prefijo(size_t posicion) const;
+
+  private:
+    vector<double, AsignadorContado<double>> _arbol;
+
+    /** Suma de las primeras `cantidad` posiciones. */
+    double _suma_primeras(size_t cantidad) const;
+};
+
+#endif
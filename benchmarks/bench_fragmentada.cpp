@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../lib.h"
+#include "../billetera.h"
+#include "../blockchain_fragmentada.h"
+
+using namespace std;
+
+// Mide el throughput de `BlockchainFragmentada` según la cantidad de
+// fragmentos. Hay un hilo productor por fragmento, y cada uno envía
+// `por_productor` transferencias de 0 entre billeteras al azar (una fracción
+// `entre_fragmentos` de ellas a otro fragmento), sin esperar cada resultado.
+// El tiempo incluye el `sincronizar` final.
+//
+// Uso: bench_fragmentada [max_fragmentos] [billeteras] [por_productor] [entre_fragmentos]
+int main(int argc, char** argv) {
+  unsigned max_fragmentos = argc > 1 ? atoi(argv[1]) : max(1u, thread::hardware_concurrency());
+  unsigned cantidad_billeteras = argc > 2 ? atoi(argv[2]) : 10000;
+  unsigned por_productor = argc > 3 ? atoi(argv[3]) : 200000;
+  double entre_fragmentos = argc > 4 ? atof(argv[4]) : 0.1;
+
+  cout << "fragmentos\ttransferencias\tops_por_seg\tescalado" << endl;
+
+  double base = 0;
+  for (unsigned fragmentos = 1; fragmentos <= max_fragmentos; fragmentos *= 2) {
+    BlockchainFragmentada blockchain(fragmentos);
+
+    // Billeteras de cada fragmento, para elegir origen y destino sin
+    // consultar a los fragmentos mientras se mide.
+    vector<vector<Billetera*>> por_fragmento(fragmentos);
+    for (unsigned i = 0; i < cantidad_billeteras; i++) {
+      Billetera* billetera = blockchain.abrir_billetera();
+      por_fragmento[blockchain.fragmento_de(billetera->id())].push_back(billetera);
+    }
+
+    auto inicio = chrono::steady_clock::now();
+
+    vector<thread> productores;
+    for (unsigned p = 0; p < fragmentos; p++) {
+      productores.emplace_back([&, p]() {
+        unsigned semilla = p + 1;
+        const vector<Billetera*>& locales = por_fragmento[p];
+        for (unsigned i = 0; i < por_productor; i++) {
+          Billetera* origen = locales[rand_r(&semilla) % locales.size()];
+          unsigned otro = p;
+          if (fragmentos > 1 && rand_r(&semilla) < entre_fragmentos * RAND_MAX) {
+            otro = (p + 1 + rand_r(&semilla) % (fragmentos - 1)) % fragmentos;
+          }
+          Billetera* destino = por_fragmento[otro][rand_r(&semilla) % por_fragmento[otro].size()];
+          if (destino != origen) {
+            blockchain.enviar_transaccion(origen, destino->id(), 0);
+          }
+        }
+      });
+    }
+    for (auto it = productores.begin(); it != productores.end(); ++it) {
+      it->join();
+    }
+    blockchain.sincronizar();
+
+    double segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    double ops = fragmentos * static_cast<double>(por_productor) / segundos;
+    if (base == 0) {
+      base = ops;
+    }
+    cout << fragmentos << "\t" << fragmentos * por_productor << "\t" << ops << "\t" << ops / base << endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,118 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../lib.h"
+#include "../billetera.h"
+#include "../blockchain.h"
+#include "../registro_persistente.h"
+
+using namespace std;
+
+// Mide cuántas transacciones por segundo se confirman en disco cuando
+// `hilos` clientes agregan y esperan cada una de sus transacciones, para
+// distintas ventanas de agrupamiento.
+//
+// Después mide `Blockchain` con un registro persistente desde un solo hilo:
+// esperando cada transacción (`agregar_transaccion`) contra agregarlas sin
+// esperar y esperar sólo la última de cada tanda de `por_tanda`.
+//
+// Uso: bench_registro_persistente [ruta] [hilos] [transacciones_por_hilo] [por_tanda]
+int main(int argc, char** argv) {
+  string ruta = argc > 1 ? argv[1] : "bench_registro_persistente.log";
+  int hilos = argc > 2 ? atoi(argv[2]) : 16;
+  int por_hilo = argc > 3 ? atoi(argv[3]) : 2000;
+  int por_tanda = argc > 4 ? atoi(argv[4]) : 256;
+
+  vector<int> ventanas_us = {0, 100, 500, 2000};
+  vector<size_t> bytes_por_grupo = {4 * 1024, 64 * 1024};
+
+  cout << "ventana_us\tbytes_por_grupo\ttps\tgrupos\ttrx_por_grupo" << endl;
+
+  for (int ventana : ventanas_us) {
+    for (size_t bytes : bytes_por_grupo) {
+      remove(ruta.c_str());
+
+      RegistroPersistente::Configuracion configuracion;
+      configuracion.ventana = chrono::microseconds(ventana);
+      configuracion.bytes_por_grupo = bytes;
+
+      double segundos;
+      unsigned long long grupos;
+      {
+        RegistroPersistente registro(ruta, configuracion);
+
+        auto inicio = chrono::steady_clock::now();
+        vector<thread> clientes;
+        for (int h = 0; h < hilos; h++) {
+          clientes.emplace_back([&registro, por_hilo, h]() {
+            for (int i = 0; i < por_hilo; i++) {
+              Transaccion transaccion = {static_cast<id_billetera>(h + 1), static_cast<id_billetera>(i + 1), 1, 0};
+              registro.esperar(registro.agregar(transaccion));
+            }
+          });
+        }
+        for (auto& cliente : clientes) {
+          cliente.join();
+        }
+        segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        grupos = registro.grupos_confirmados();
+      }
+
+      double total = static_cast<double>(hilos) * por_hilo;
+      cout << ventana << "\t" << bytes << "\t" << static_cast<long long>(total / segundos)
+           << "\t" << grupos << "\t" << total / grupos << endl;
+    }
+  }
+
+  cout << endl << "blockchain\tventana_us\ttps\tgrupos\ttrx_por_grupo" << endl;
+
+  for (int ventana : ventanas_us) {
+    for (bool sin_esperar : {false, true}) {
+      remove(ruta.c_str());
+
+      RegistroPersistente::Configuracion configuracion;
+      configuracion.ventana = chrono::microseconds(ventana);
+
+      double segundos;
+      unsigned long long grupos;
+      {
+        RegistroPersistente registro(ruta, configuracion);
+        Blockchain blockchain;
+        blockchain.persistir_en(&registro);
+        Billetera* origen = blockchain.abrir_billetera();
+        Billetera* destino = blockchain.abrir_billetera();
+        unsigned long long grupos_antes = registro.grupos_confirmados();
+
+        auto inicio = chrono::steady_clock::now();
+        unsigned long long ticket = 0;
+        for (int i = 0; i < por_hilo; i++) {
+          if (!sin_esperar) {
+            blockchain.agregar_transaccion(origen, destino->id(), 0);
+            continue;
+          }
+          ticket = blockchain.agregar_sin_esperar(origen, destino->id(), 0);
+          if ((i + 1) % por_tanda == 0) {
+            blockchain.esperar_durable(ticket);
+          }
+        }
+        if (sin_esperar) {
+          blockchain.esperar_durable(ticket);
+        }
+        segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+        grupos = registro.grupos_confirmados() - grupos_antes;
+      }
+
+      cout << (sin_esperar ? "sin_esperar" : "esperando_cada") << "\t" << ventana << "\t"
+           << static_cast<long long>(por_hilo / segundos) << "\t" << grupos << "\t"
+           << static_cast<double>(por_hilo) / grupos << endl;
+    }
+  }
+
+  remove(ruta.c_str());
+  return 0;
+}
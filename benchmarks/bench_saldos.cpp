@@ -0,0 +1,93 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../lib.h"
+#include "../billetera.h"
+#include "../blockchain.h"
+#include "../calendario.h"
+
+using namespace std;
+
+// Compara las consultas por lote de `Blockchain` contra un ciclo de
+// consultas individuales, pidiendo `por_lote` billeteras al azar por lote.
+//
+// Uso: bench_saldos [billeteras] [transacciones] [por_lote] [lotes]
+int main(int argc, char** argv) {
+  unsigned cantidad_billeteras = argc > 1 ? atoi(argv[1]) : 1000000;
+  unsigned cantidad_transacciones = argc > 2 ? atoi(argv[2]) : 10000000;
+  size_t por_lote = argc > 3 ? atoi(argv[3]) : 256;
+  size_t lotes = argc > 4 ? atoi(argv[4]) : 20000;
+
+  // Se arma con la carga masiva: agregar las transacciones de a una tardaría
+  // demasiado.
+  vector<Transaccion> listado;
+  for (id_billetera id = 1; id <= cantidad_billeteras; id++) {
+    listado.push_back({0, id, 100, 0});
+  }
+  for (unsigned i = 0; i < cantidad_transacciones; i++) {
+    id_billetera origen = rand() % cantidad_billeteras + 1;
+    id_billetera destino = rand() % cantidad_billeteras + 1;
+    if (origen != destino) {
+      listado.push_back({origen, destino, 0, Calendario::dia(i * 365ull / cantidad_transacciones)});
+    }
+  }
+  Blockchain blockchain(listado);
+  listado = {};
+
+  vector<vector<id_billetera>> pedidos(lotes);
+  vector<vector<timestamp>> momentos(lotes);
+  for (size_t l = 0; l < lotes; l++) {
+    for (size_t i = 0; i < por_lote; i++) {
+      pedidos[l].push_back(rand() % cantidad_billeteras + 1);
+      momentos[l].push_back(Calendario::dia(rand() % 365));
+    }
+  }
+
+  cout << "consulta\tmodo\tns_por_billetera" << endl;
+
+  auto medir = [&](const char* consulta, const char* modo, auto&& correr) {
+    unsigned long long control = 0;
+    auto inicio = chrono::steady_clock::now();
+    for (size_t l = 0; l < lotes; l++) {
+      control += correr(l);
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - inicio).count();
+    cout << consulta << "\t" << modo << "\t" << ns / (lotes * por_lote) << "\t(" << control << ")" << endl;
+  };
+
+  vector<monto> salida;
+  medir("saldo", "individual", [&](size_t l) {
+    unsigned long long suma = 0;
+    for (id_billetera id : pedidos[l]) {
+      suma += blockchain.billetera(id)->saldo();
+    }
+    return suma;
+  });
+  medir("saldo", "lote", [&](size_t l) {
+    blockchain.saldos(pedidos[l], salida);
+    unsigned long long suma = 0;
+    for (monto saldo : salida) {
+      suma += saldo;
+    }
+    return suma;
+  });
+  medir("saldo_al_fin_del_dia", "individual", [&](size_t l) {
+    unsigned long long suma = 0;
+    for (size_t i = 0; i < por_lote; i++) {
+      suma += blockchain.billetera(pedidos[l][i])->saldo_al_fin_del_dia(momentos[l][i]);
+    }
+    return suma;
+  });
+  medir("saldo_al_fin_del_dia", "lote", [&](size_t l) {
+    blockchain.saldos_al_fin_del_dia(pedidos[l], momentos[l], salida);
+    unsigned long long suma = 0;
+    for (monto saldo : salida) {
+      suma += saldo;
+    }
+    return suma;
+  });
+
+  return 0;
+}
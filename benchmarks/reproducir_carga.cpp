@@ -0,0 +1,507 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "../lib.h"
+#include "../billetera.h"
+#include "../blockchain.h"
+#include "../calendario.h"
+#include "../traza.h"
+
+using namespace std;
+
+// Reproduce una carga de trabajo sobre una `Blockchain`, con el reloj fijado
+// en el momento de cada operación, y reporta por fase el throughput, los
+// percentiles de latencia y el pico de memoria residente de la fase.
+//
+// El pico de cada fase se mide reiniciando el máximo de memoria residente del
+// proceso al empezarla (escribiendo "5" en /proc/self/clear_refs) y leyendo
+// VmHWM de /proc/self/status al terminarla. Si el kernel no permite
+// reiniciarlo, se avisa por stderr y la columna pasa a ser el pico acumulado
+// desde el inicio del proceso.
+//
+// La carga se lee de un archivo CSV o se genera sintéticamente.
+//
+// Uso:
+//   reproducir_carga <archivo.csv> [--perezosos] [--traza archivo.json]
+//   reproducir_carga --sintetica [--billeteras N] [--dias D]
+//                    [--transacciones-por-dia T] [--consultas C] [--zipf S]
+//                    [--semilla X] [--guardar archivo.csv] [--perezosos]
+//                    [--traza archivo.json]
+//
+// Con --traza se registran los tramos de la reproducción y al final se
+// vuelcan en formato Chrome trace.
+//
+// Con --guardar la carga se escribe en el formato CSV de abajo, con los
+// montos en precisión completa, y se relee para verificar que reproduce
+// exactamente las mismas operaciones.
+//
+// Formato del CSV (una operación por línea; las líneas vacías o que empiezan
+// con '#' se ignoran). Las billeteras se nombran por su orden de apertura,
+// empezando en 0, porque los ids los asigna la blockchain:
+//
+//   fase,<nombre>
+//   abrir,<momento>
+//   transferir,<momento>,<origen>,<destino>,<monto>
+//   saldo,<momento>,<billetera>
+//   saldo_dia,<momento>,<billetera>,<dia>
+//   frecuentes,<momento>,<billetera>,<k>
+//   ultimas,<momento>,<billetera>,<k>
+//
+// Los momentos y el día de `saldo_dia` son timestamps en segundos.
+
+namespace {
+
+enum class Tipo { FASE, ABRIR, TRANSFERIR, SALDO, SALDO_DIA, FRECUENTES, ULTIMAS };
+
+struct Operacion {
+  Tipo tipo;
+  timestamp momento;
+  unsigned billetera;
+  unsigned otra;     // destino de TRANSFERIR
+  double valor;      // monto de TRANSFERIR, día de SALDO_DIA, k de FRECUENTES y ULTIMAS
+  string fase;       // nombre de FASE
+};
+
+struct Opciones {
+  string archivo;
+  bool sintetica = false;
+  unsigned billeteras = 1000;
+  unsigned dias = 60;
+  unsigned transacciones_por_dia = 200;
+  unsigned consultas = 20000;
+  double zipf = 1.1;
+  unsigned semilla = 1;
+  string guardar;
+  bool perezosos = false;
+  string traza;
+};
+
+// --- Lectura y escritura del CSV -------------------------------------------
+
+vector<string> separar(const string& linea) {
+  vector<string> campos;
+  stringstream flujo(linea);
+  string campo;
+  while (getline(flujo, campo, ',')) {
+    campos.push_back(campo);
+  }
+  return campos;
+}
+
+bool leer_carga(const string& ruta, vector<Operacion>& operaciones) {
+  ifstream archivo(ruta);
+  if (!archivo) {
+    cerr << "no se pudo abrir " << ruta << endl;
+    return false;
+  }
+
+  string linea;
+  for (size_t numero = 1; getline(archivo, linea); numero++) {
+    if (linea.empty() || linea[0] == '#') {
+      continue;
+    }
+    vector<string> c = separar(linea);
+
+    Operacion op = {Tipo::FASE, 0, 0, 0, 0, ""};
+    bool valida = true;
+    try {
+      if (c[0] == "fase" && c.size() == 2) {
+        op.fase = c[1];
+      } else if (c[0] == "abrir" && c.size() == 2) {
+        op.tipo = Tipo::ABRIR;
+        op.momento = stoul(c[1]);
+      } else if (c[0] == "transferir" && c.size() == 5) {
+        op = {Tipo::TRANSFERIR, static_cast<timestamp>(stoul(c[1])), static_cast<unsigned>(stoul(c[2])), static_cast<unsigned>(stoul(c[3])), stod(c[4]), ""};
+      } else if (c[0] == "saldo" && c.size() == 3) {
+        op = {Tipo::SALDO, static_cast<timestamp>(stoul(c[1])), static_cast<unsigned>(stoul(c[2])), 0, 0, ""};
+      } else if (c[0] == "saldo_dia" && c.size() == 4) {
+        op = {Tipo::SALDO_DIA, static_cast<timestamp>(stoul(c[1])), static_cast<unsigned>(stoul(c[2])), 0, stod(c[3]), ""};
+      } else if (c[0] == "frecuentes" && c.size() == 4) {
+        op = {Tipo::FRECUENTES, static_cast<timestamp>(stoul(c[1])), static_cast<unsigned>(stoul(c[2])), 0, stod(c[3]), ""};
+      } else if (c[0] == "ultimas" && c.size() == 4) {
+        op = {Tipo::ULTIMAS, static_cast<timestamp>(stoul(c[1])), static_cast<unsigned>(stoul(c[2])), 0, stod(c[3]), ""};
+      } else {
+        valida = false;
+      }
+    } catch (const exception&) {
+      valida = false;
+    }
+
+    if (!valida) {
+      cerr << ruta << ":" << numero << ": operación inválida: " << linea << endl;
+      return false;
+    }
+    operaciones.push_back(op);
+  }
+
+  return true;
+}
+
+bool guardar_carga(const string& ruta, const vector<Operacion>& operaciones) {
+  ofstream archivo(ruta);
+  if (!archivo) {
+    cerr << "no se pudo crear " << ruta << endl;
+    return false;
+  }
+
+  // Con todos los dígitos, los montos se leen exactamente como se guardaron.
+  archivo << setprecision(numeric_limits<double>::max_digits10);
+
+  for (const Operacion& op : operaciones) {
+    switch (op.tipo) {
+      case Tipo::FASE:       archivo << "fase," << op.fase; break;
+      case Tipo::ABRIR:      archivo << "abrir," << op.momento; break;
+      case Tipo::TRANSFERIR: archivo << "transferir," << op.momento << "," << op.billetera << "," << op.otra << "," << op.valor; break;
+      case Tipo::SALDO:      archivo << "saldo," << op.momento << "," << op.billetera; break;
+      case Tipo::SALDO_DIA:  archivo << "saldo_dia," << op.momento << "," << op.billetera << "," << static_cast<timestamp>(op.valor); break;
+      case Tipo::FRECUENTES: archivo << "frecuentes," << op.momento << "," << op.billetera << "," << op.valor; break;
+      case Tipo::ULTIMAS:    archivo << "ultimas," << op.momento << "," << op.billetera << "," << op.valor; break;
+    }
+    archivo << "\n";
+  }
+
+  return static_cast<bool>(archivo);
+}
+
+// Relee lo guardado en `ruta` y verifica que reproduzca exactamente
+// `operaciones`.
+bool verificar_carga_guardada(const string& ruta, const vector<Operacion>& operaciones) {
+  vector<Operacion> leidas;
+  if (!leer_carga(ruta, leidas)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < max(leidas.size(), operaciones.size()); i++) {
+    bool igual = i < leidas.size() && i < operaciones.size();
+    if (igual) {
+      const Operacion& a = operaciones[i];
+      const Operacion& b = leidas[i];
+      igual = a.tipo == b.tipo && a.momento == b.momento && a.billetera == b.billetera && a.otra == b.otra &&
+              a.valor == b.valor && a.fase == b.fase;
+    }
+    if (!igual) {
+      cerr << ruta << ": la operación " << i + 1 << " no se guardó igual a la original" << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// --- Generación sintética --------------------------------------------------
+
+// Elige billeteras con popularidad Zipf: la de rango r se elige con
+// probabilidad proporcional a 1 / r^s. Los rangos se asignan a las
+// billeteras en un orden al azar, para que las populares no sean siempre las
+// primeras en abrirse.
+class ElectorZipf {
+  public:
+    ElectorZipf(unsigned cantidad, double s, mt19937& azar) : _billeteras(cantidad) {
+      double total = 0;
+      for (unsigned r = 1; r <= cantidad; r++) {
+        total += 1 / pow(r, s);
+        _acumuladas.push_back(total);
+      }
+      for (unsigned b = 0; b < cantidad; b++) {
+        _billeteras[b] = b;
+      }
+      shuffle(_billeteras.begin(), _billeteras.end(), azar);
+    }
+
+    unsigned elegir(mt19937& azar) const {
+      double x = uniform_real_distribution<double>(0, _acumuladas.back())(azar);
+      size_t rango = upper_bound(_acumuladas.begin(), _acumuladas.end(), x) - _acumuladas.begin();
+      return _billeteras[min(rango, _billeteras.size() - 1)];
+    }
+
+  private:
+    vector<double> _acumuladas;
+    vector<unsigned> _billeteras;
+};
+
+// Tres fases: apertura de todas las billeteras el día 0; transferencias
+// durante `dias` días, con días de ráfaga (diez veces más transacciones) y
+// rachas largas sin actividad; y consultas al final.
+vector<Operacion> generar_carga(const Opciones& opciones) {
+  mt19937 azar(opciones.semilla);
+  ElectorZipf elector(max(2u, opciones.billeteras), opciones.zipf, azar);
+  uniform_real_distribution<double> moneda(0, 1);
+  vector<Operacion> operaciones;
+
+  operaciones.push_back({Tipo::FASE, 0, 0, 0, 0, "apertura"});
+  for (unsigned b = 0; b < max(2u, opciones.billeteras); b++) {
+    operaciones.push_back({Tipo::ABRIR, Calendario::dia(0) + b / 100, 0, 0, 0, ""});
+  }
+
+  operaciones.push_back({Tipo::FASE, 0, 0, 0, 0, "transferencias"});
+  unsigned dias_inactivos = 0;
+  for (unsigned d = 1; d <= opciones.dias; d++) {
+    if (dias_inactivos > 0) {
+      dias_inactivos--;
+      continue;
+    }
+    if (moneda(azar) < 0.03) {
+      dias_inactivos = uniform_int_distribution<unsigned>(5, 30)(azar);
+      continue;
+    }
+
+    unsigned cantidad = opciones.transacciones_por_dia * (moneda(azar) < 0.1 ? 10 : 1);
+    vector<timestamp> momentos;
+    for (unsigned i = 0; i < cantidad; i++) {
+      momentos.push_back(Calendario::dia(d) + uniform_int_distribution<timestamp>(0, 86399)(azar));
+    }
+    sort(momentos.begin(), momentos.end());
+
+    for (timestamp momento : momentos) {
+      unsigned origen = elector.elegir(azar);
+      unsigned destino = elector.elegir(azar);
+      while (destino == origen) {
+        destino = elector.elegir(azar);
+      }
+      double monto = uniform_int_distribution<int>(1, 5)(azar);
+      operaciones.push_back({Tipo::TRANSFERIR, momento, origen, destino, monto, ""});
+    }
+  }
+
+  operaciones.push_back({Tipo::FASE, 0, 0, 0, 0, "consultas"});
+  timestamp fin = Calendario::dia(opciones.dias + 1);
+  for (unsigned i = 0; i < opciones.consultas; i++) {
+    unsigned billetera = elector.elegir(azar);
+    double tipo = moneda(azar);
+    if (tipo < 0.4) {
+      operaciones.push_back({Tipo::SALDO, fin, billetera, 0, 0, ""});
+    } else if (tipo < 0.7) {
+      timestamp dia = Calendario::dia(uniform_int_distribution<unsigned>(0, opciones.dias)(azar));
+      operaciones.push_back({Tipo::SALDO_DIA, fin, billetera, 0, static_cast<double>(dia), ""});
+    } else if (tipo < 0.85) {
+      operaciones.push_back({Tipo::FRECUENTES, fin, billetera, 0, 5, ""});
+    } else {
+      operaciones.push_back({Tipo::ULTIMAS, fin, billetera, 0, 10, ""});
+    }
+  }
+
+  return operaciones;
+}
+
+// --- Reproducción ----------------------------------------------------------
+
+struct ResultadoFase {
+  string nombre;
+  vector<double> latencias_us;
+  size_t rechazadas = 0;
+  double segundos = 0;
+  long rss_pico_kb = 0;
+};
+
+// Reinicia el pico de memoria residente del proceso a la memoria residente
+// actual. Devuelve `false` si el kernel no lo permite.
+bool reiniciar_rss_pico() {
+  ofstream clear_refs("/proc/self/clear_refs");
+  clear_refs << "5";
+  clear_refs.close();
+  return !clear_refs.fail();
+}
+
+// Pico de memoria residente desde el último reinicio, en KB. Sin
+// /proc/self/status se usa el de getrusage, que nunca se reinicia.
+long rss_pico_kb() {
+  ifstream estado("/proc/self/status");
+  string linea;
+  while (getline(estado, linea)) {
+    if (linea.compare(0, 6, "VmHWM:") == 0) {
+      return atol(linea.c_str() + 6);
+    }
+  }
+
+  rusage uso;
+  getrusage(RUSAGE_SELF, &uso);
+  return uso.ru_maxrss; // En Linux, en KB.
+}
+
+double percentil(const vector<double>& ordenadas, double p) {
+  if (ordenadas.empty()) {
+    return 0;
+  }
+  size_t posicion = static_cast<size_t>(ceil(p * ordenadas.size())) - (p > 0 ? 1 : 0);
+  return ordenadas[min(posicion, ordenadas.size() - 1)];
+}
+
+void reportar(ResultadoFase& fase) {
+  sort(fase.latencias_us.begin(), fase.latencias_us.end());
+  size_t operaciones = fase.latencias_us.size();
+  cout << fase.nombre << "\t" << operaciones << "\t" << fase.rechazadas << "\t"
+       << static_cast<long long>(fase.segundos > 0 ? operaciones / fase.segundos : 0) << "\t"
+       << percentil(fase.latencias_us, 0.5) << "\t" << percentil(fase.latencias_us, 0.9) << "\t"
+       << percentil(fase.latencias_us, 0.99) << "\t" << percentil(fase.latencias_us, 1) << "\t"
+       << fase.rss_pico_kb << endl;
+}
+
+// Ejecuta una operación. Devuelve `false` si fue rechazada o nombra una
+// billetera que no existe.
+bool ejecutar(Blockchain& blockchain, vector<Billetera*>& billeteras, const Operacion& op, unsigned long long& control) {
+  if (op.tipo == Tipo::ABRIR) {
+    billeteras.push_back(blockchain.abrir_billetera());
+    return true;
+  }
+  if (op.billetera >= billeteras.size() || (op.tipo == Tipo::TRANSFERIR && op.otra >= billeteras.size())) {
+    return false;
+  }
+
+  Billetera* billetera = billeteras[op.billetera];
+  switch (op.tipo) {
+    case Tipo::TRANSFERIR:
+      return blockchain.agregar_transaccion(billetera, billeteras[op.otra]->id(), op.valor);
+    case Tipo::SALDO:
+      control += billetera->saldo();
+      return true;
+    case Tipo::SALDO_DIA:
+      control += billetera->saldo_al_fin_del_dia(static_cast<timestamp>(op.valor));
+      return true;
+    case Tipo::FRECUENTES:
+      control += billetera->detinatarios_mas_frecuentes(static_cast<int>(op.valor)).size();
+      return true;
+    case Tipo::ULTIMAS:
+      control += billetera->ultimas_transacciones(static_cast<int>(op.valor)).size();
+      return true;
+    default:
+      return true;
+  }
+}
+
+void reproducir(const vector<Operacion>& operaciones, bool perezosos) {
+  Blockchain blockchain;
+  blockchain.fijar_indices_perezosos(perezosos);
+  vector<Billetera*> billeteras;
+  unsigned long long control = 0;
+
+  cout << "fase\toperaciones\trechazadas\tops_por_seg\tp50_us\tp90_us\tp99_us\tmax_us\trss_pico_kb" << endl;
+
+  bool pico_por_fase = reiniciar_rss_pico();
+  if (!pico_por_fase) {
+    cerr << "No se puede reiniciar el pico de memoria: rss_pico_kb es acumulado." << endl;
+  }
+
+  ResultadoFase fase;
+  fase.nombre = "sin_nombre";
+  auto inicio_fase = chrono::steady_clock::now();
+
+  auto cerrar_fase = [&]() {
+    fase.segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio_fase).count();
+    fase.rss_pico_kb = rss_pico_kb();
+    if (!fase.latencias_us.empty()) {
+      reportar(fase);
+    }
+  };
+
+  for (const Operacion& op : operaciones) {
+    if (op.tipo == Tipo::FASE) {
+      cerrar_fase();
+      fase = ResultadoFase();
+      fase.nombre = op.fase;
+      if (pico_por_fase) {
+        reiniciar_rss_pico();
+      }
+      inicio_fase = chrono::steady_clock::now();
+      continue;
+    }
+
+    Calendario::fijar(op.momento);
+    auto inicio = chrono::steady_clock::now();
+    bool aceptada = ejecutar(blockchain, billeteras, op, control);
+    auto fin = chrono::steady_clock::now();
+
+    fase.latencias_us.push_back(chrono::duration<double, micro>(fin - inicio).count());
+    if (!aceptada) {
+      fase.rechazadas++;
+    }
+  }
+  cerrar_fase();
+
+  Calendario::restaurar();
+  cerr << "control: " << control << endl;
+}
+
+bool leer_opciones(int argc, char** argv, Opciones& opciones) {
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    bool con_valor = i + 1 < argc;
+    if (arg == "--sintetica") {
+      opciones.sintetica = true;
+    } else if (arg == "--perezosos") {
+      opciones.perezosos = true;
+    } else if (arg == "--billeteras" && con_valor) {
+      opciones.billeteras = atoi(argv[++i]);
+    } else if (arg == "--dias" && con_valor) {
+      opciones.dias = atoi(argv[++i]);
+    } else if (arg == "--transacciones-por-dia" && con_valor) {
+      opciones.transacciones_por_dia = atoi(argv[++i]);
+    } else if (arg == "--consultas" && con_valor) {
+      opciones.consultas = atoi(argv[++i]);
+    } else if (arg == "--zipf" && con_valor) {
+      opciones.zipf = atof(argv[++i]);
+    } else if (arg == "--semilla" && con_valor) {
+      opciones.semilla = atoi(argv[++i]);
+    } else if (arg == "--guardar" && con_valor) {
+      opciones.guardar = argv[++i];
+    } else if (arg == "--traza" && con_valor) {
+      opciones.traza = argv[++i];
+    } else if (arg[0] != '-' && opciones.archivo.empty()) {
+      opciones.archivo = arg;
+    } else {
+      cerr << "opción desconocida: " << arg << endl;
+      return false;
+    }
+  }
+  return opciones.sintetica != !opciones.archivo.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Opciones opciones;
+  if (!leer_opciones(argc, argv, opciones)) {
+    cerr << "uso: reproducir_carga <archivo.csv> [--perezosos] [--traza archivo.json]" << endl
+         << "     reproducir_carga --sintetica [--billeteras N] [--dias D] [--transacciones-por-dia T]" << endl
+         << "                      [--consultas C] [--zipf S] [--semilla X] [--guardar archivo.csv] [--perezosos]" << endl
+         << "                      [--traza archivo.json]" << endl;
+    return 1;
+  }
+
+  vector<Operacion> operaciones;
+  if (opciones.sintetica) {
+    operaciones = generar_carga(opciones);
+  } else if (!leer_carga(opciones.archivo, operaciones)) {
+    return 1;
+  }
+
+  if (!opciones.guardar.empty() &&
+      !(guardar_carga(opciones.guardar, operaciones) && verificar_carga_guardada(opciones.guardar, operaciones))) {
+    return 1;
+  }
+
+  if (!opciones.traza.empty()) {
+    Traza::activar();
+  }
+
+  reproducir(operaciones, opciones.perezosos);
+
+  if (!opciones.traza.empty()) {
+    Traza::desactivar();
+    if (!Traza::volcar(opciones.traza)) {
+      cerr << "no se pudo escribir " << opciones.traza << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
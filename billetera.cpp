@@ -1,15 +1,29 @@
+#include <unordered_map>
 #include <vector>
 #include "lib.h"
 #include "calendario.h"
 #include "billetera.h"
 #include "blockchain.h"
+#include "traza.h"
 
 using namespace std;
 
 Billetera::Billetera(const id_billetera id, Blockchain* blockchain)
   : _id(id)
   , _blockchain(blockchain)
-  , _saldo(0) {
+  , _saldo(0)
+  , _memoria()
+  , _billeteras_por_cantidad_de_transacciones(AsignadorContado<pair<const int, Destinatarios>>(&_memoria.destinatarios))
+  , _dias_ventana(VENTANA_DESTINATARIOS)
+  , _dia_de_apertura(0)
+  , _transacciones(id, &_memoria.historial)
+  , _indices_materializados(!blockchain->indices_perezosos())
+  , _ultima_consulta(0) {
+  // Con índices perezosos las estructuras se crean recién al materializar.
+  if (_indices_materializados) {
+    _destinatarios_en_ventana = make_unique<FrecuenciasVentana>(_dias_ventana, &_memoria.destinatarios_en_ventana);
+    _saldo_por_dia = make_unique<ArbolFenwick>(&_memoria.saldo_por_dia);
+  }
 }
 
 id_billetera Billetera::id() const {
@@ -18,19 +32,36 @@ id_billetera Billetera::id() const {
 
 
 void Billetera::notificar_transaccion(Transaccion t) {
-  _transacciones.push_back(t); // O(1)
+  TramoTraza tramo("notificar_transaccion"); // O(1)
+  tramo.argumento("billetera", _id); // O(1)
+
+  // Si es la trx semilla.
+  if (_transacciones.cantidad() == 0) { // O(1)
+    _dia_de_apertura = t._timestamp; // O(1)
+  }
 
+  _transacciones.agregar(t); // O(1) amortizado
+  monto saldo_anterior = _saldo; // O(1)
   _actualizar_saldo(t); // O(1)
-  _actualizar_saldo_por_dia(t); // O(D log(D))
+
+  // Sin índices sólo se guarda el historial: se arman en la primera consulta.
+  if (!_indices_materializados) { // O(1)
+    return; // O(1)
+  }
+
+  _actualizar_saldo_por_dia(t, saldo_anterior); // O(G + log²(D))
 
   id_billetera billetera_amigo = _conseguir_billetera_amigo(t); // O(1)
   if(billetera_amigo != 0 && t.destino == billetera_amigo) { // Si no es a la semilla y envié dinero (O(1))
     _actualizar_billeteras_por_cantidad_de_transacciones(t); // O(C)
+
+    TramoTraza tramo_ventana("ventana"); // O(1)
+    _destinatarios_en_ventana->registrar(billetera_amigo, t._timestamp); // O(1) amortizado
   }
 
-  // COMPLEJIDAD TOTAL DEL MÉTODO: O(D*log D + C)
-  //   - 3 operaciones O(1) + O(D log D) + O(C)
-  //   - 3*O(1) + O(D log D) + O(C) = O(1) + O(D log D) + O(C) = O(D*log D + C)
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(G + log²(D) + C), u O(1) amortizado sin índices
+  //   - 7 operaciones O(1) + O(G + log²(D)) + O(C)
+  //   - 7*O(1) + O(G + log²(D)) + O(C) = O(G + log²(D) + C)
 }
 
 monto Billetera::saldo() const {
@@ -39,45 +70,43 @@ monto Billetera::saldo() const {
   // COMPLEJIDAD TOTAL DEL MÉTODO: O(1)
 }
 
+unsigned Billetera::cantidad_transacciones() const {
+  return _transacciones.cantidad(); // O(1)
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(1)
+}
+
 monto Billetera::saldo_al_fin_del_dia(timestamp t) const {
-  timestamp dia = Calendario::fin_del_dia(t); // O(1)
-  
+  _materializar_indices(); // O(1), u O(T + D + C * log(C)) la primera vez
+
+  size_t dia = _dia_desde_apertura(t); // O(1)
+
   // Nos fijamos si el dia pedido es "en el futuro"
-  auto it = _saldo_por_dia.rbegin(); // O(1)
-  timestamp ultimo_dia_guardado = it->first; // O(1)
-  if(ultimo_dia_guardado < dia) { // O(1)
+  if(dia >= _saldo_por_dia->tamano()) { // O(1)
     return _saldo; // O(1)
   }
-  
-  return _saldo_por_dia.at(dia); // O(log D)
+
+  // El árbol acumula las variaciones de `_saldo` con signo; pasamos por un
+  // entero con signo para respetar la misma aritmética módulo 2^32.
+  return static_cast<monto>(static_cast<long long>(_saldo_por_dia->prefijo(dia))); // O(log D)
 
   // COMPLEJIDAD TOTAL DEL MÉTODO: O(log D)
-  //   - 5 operaciones O(1) + O(log D)
-  //   - 5*O(1) + O(log D) = O(1) + O(log D) = O(log D)
+  //   - 3 operaciones O(1) + O(log D)
+  //   - 3*O(1) + O(log D) = O(1) + O(log D) = O(log D)
 }
 
 vector<Transaccion> Billetera::ultimas_transacciones(int k) const { // O(k)
-  vector<Transaccion> ret; // O(1)
-  
-  // Notar que `rbegin` y `rend` recorren la lista en orden inverso.
-  auto it = _transacciones.rbegin(); // O(1)
-  
-  // Complejidad total del ciclo: O(k)
-  //   - O(k) iteraciones
-  //   - O(1) operaciones en cada iteración
-  while(it != _transacciones.rend() && ret.size() < k) { // O(k) iteraciones. Con 0 <= k <= _transacciones.size() (cantidad de trx que hizo Billetera).
-    ret.push_back(*it); // O(1)
-    ++it; // O(1)
-  }
-
-  return ret; // O(1)
+  // El historial decodifica de a bloques desde el final, así que además de
+  // las k pedidas puede decodificar a lo sumo un bloque de más.
+  return _transacciones.ultimas(k); // O(k + TRANSACCIONES_POR_BLOQUE)
 
   // COMPLEJIDAD TOTAL DEL MÉTODO: O(k)
-  //   - 3 operaciones O(1) + O(k)
-  //   - 3*O(1) + O(k) = O(1) + O(k) = O(k)
+  //   - TRANSACCIONES_POR_BLOQUE es una constante: O(k + TRANSACCIONES_POR_BLOQUE) = O(k)
 }
 
 vector<id_billetera> Billetera::detinatarios_mas_frecuentes(int k) const { // O(k)
+  _materializar_indices(); // O(1), u O(T + D + C * log(C)) la primera vez
+
   // recorro el map usando un iterador en orden inverso, que me lleva por todos
   // los pares de entradas desde la mayor clave hasta la menor.
   vector<id_billetera> ret = {};  // O(1)
@@ -90,7 +119,7 @@ vector<id_billetera> Billetera::detinatarios_mas_frecuentes(int k) const { // O(
   //    Ambos ciclos cortan cuando ret.size() >= k. En cada iteración, el while "interno" modifica ret.
   //  - El resto de las operaciones son O(1)
   while (it != _billeteras_por_cantidad_de_transacciones.rend() && ret.size() < k) { // O(k) (justificado arriba)
-    vector<id_billetera> siguiente_grupo = it->second; // O(1)
+    const Destinatarios& siguiente_grupo = it->second; // O(1)
     int i = 0; // O(1)
 
     while (i < siguiente_grupo.size() && ret.size() < k) { // O(...) (justificado arriba)
@@ -108,10 +137,173 @@ vector<id_billetera> Billetera::detinatarios_mas_frecuentes(int k) const { // O(
   //   - 3*O(1) + O(k) = O(1) + O(k) = O(k)
 }
 
+vector<id_billetera> Billetera::destinatarios_mas_frecuentes_en_ventana(int k) const {
+  _materializar_indices(); // O(1), u O(T + D + C * log(C)) la primera vez
+  _destinatarios_en_ventana->avanzar(Calendario::tiempo_actual()); // O(1) amortizado
+
+  return _destinatarios_en_ventana->mas_frecuentes(k); // O(k)
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(k) amortizado
+}
+
+void Billetera::fijar_ventana_destinatarios(unsigned dias) {
+  _dias_ventana = dias; // O(1)
+
+  // Sin índices alcanza con recordar el largo: se usa al materializarlos.
+  if (!_indices_materializados) { // O(1)
+    return; // O(1)
+  }
+
+  _destinatarios_en_ventana = make_unique<FrecuenciasVentana>(dias, &_memoria.destinatarios_en_ventana); // O(C)
+
+  // Complejidad total del recorrido: O(T), cada registro es O(1) amortizado.
+  _transacciones.para_cada([this](const Transaccion& t) {
+    if (t.origen == _id) { // O(1)
+      _destinatarios_en_ventana->registrar(t.destino, t._timestamp); // O(1) amortizado
+    }
+  });
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(T)
+}
+
+
+bool Billetera::indices_materializados() const {
+  return _indices_materializados; // O(1)
+}
+
+void Billetera::liberar_indices() {
+  _saldo_por_dia.reset(); // O(D)
+  _billeteras_por_cantidad_de_transacciones.clear(); // O(C)
+  _destinatarios_en_ventana.reset(); // O(C)
+  _indices_materializados = false; // O(1)
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(D + C)
+}
+
+MemoriaBilletera Billetera::memoria() const {
+  MemoriaBilletera ret = _memoria; // O(1)
+  ret.objeto = sizeof(Billetera); // O(1)
+
+  // Los objetos de la ventana y del árbol se piden aparte de la billetera.
+  if (_destinatarios_en_ventana) { // O(1)
+    ret.destinatarios_en_ventana += sizeof(FrecuenciasVentana); // O(1)
+  }
+  if (_saldo_por_dia) { // O(1)
+    ret.saldo_por_dia += sizeof(ArbolFenwick); // O(1)
+  }
+  return ret; // O(1)
+}
+
+timestamp Billetera::ultima_consulta() const {
+  return _ultima_consulta.load(memory_order_relaxed); // O(1)
+}
+
 
 /** Métodos privados auxiliares */
 
-id_billetera Billetera::_conseguir_billetera_amigo(Transaccion t) {
+void Billetera::_materializar_indices() const {
+  // Sin índices perezosos nadie libera índices por inactividad, y no
+  // escribir nada deja las consultas a billeteras con índices como lecturas
+  // puras.
+  if (_blockchain->indices_perezosos()) { // O(1)
+    _ultima_consulta.store(Calendario::tiempo_actual(), memory_order_relaxed); // O(1)
+  }
+
+  if (_indices_materializados) { // O(1)
+    return; // O(1)
+  }
+
+  TramoTraza tramo("materializar_indices"); // O(1)
+  tramo.argumento("billetera", _id); // O(1)
+  tramo.argumento("transacciones", _transacciones.cantidad()); // O(1)
+
+  vector<Transaccion> transacciones; // O(1)
+  transacciones.reserve(_transacciones.cantidad()); // O(1)
+  _transacciones.para_cada([&transacciones](const Transaccion& t) {
+    transacciones.push_back(t); // O(1) amortizado
+  }); // O(T)
+
+  _construir_indices(transacciones); // O(T + D + C * log(C))
+  _indices_materializados = true; // O(1)
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(1) si ya estaban, O(T + D + C * log(C)) si no
+}
+
+void Billetera::_anticipar() const {
+  anticipar_lectura(&_saldo); // O(1)
+  anticipar_lectura(&_dia_de_apertura); // O(1)
+  anticipar_lectura(&_saldo_por_dia); // O(1)
+  anticipar_lectura(&_indices_materializados); // O(1)
+}
+
+void Billetera::_anticipar_saldo_al_fin_del_dia(timestamp t) const {
+  size_t dia = _dia_desde_apertura(t); // O(1)
+  if (_indices_materializados && dia < _saldo_por_dia->tamano()) { // O(1)
+    _saldo_por_dia->anticipar_prefijo(dia); // O(log D)
+  }
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(log D)
+}
+
+void Billetera::_cargar(const vector<Transaccion>& transacciones) {
+  if (transacciones.empty()) { // O(1)
+    return; // O(1)
+  }
+  _dia_de_apertura = transacciones.front()._timestamp; // O(1)
+
+  for (const Transaccion& t : transacciones) { // O(T) iteraciones
+    _transacciones.agregar(t); // O(1) amortizado
+    _actualizar_saldo(t); // O(1)
+  }
+
+  if (_indices_materializados) { // O(1)
+    _construir_indices(transacciones); // O(T + D + C * log(C))
+  }
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(T + D + C * log(C))
+}
+
+void Billetera::_construir_indices(const vector<Transaccion>& transacciones) const {
+  vector<double> variaciones; // O(1)
+  monto saldo = 0; // O(1)
+  unordered_map<id_billetera, int> envios; // O(1)
+  vector<id_billetera> destinatarios; // O(1)
+  _destinatarios_en_ventana = make_unique<FrecuenciasVentana>(_dias_ventana, &_memoria.destinatarios_en_ventana); // O(C)
+
+  // Complejidad total del ciclo: O(T + D)
+  //  - Los resize suman en total D posiciones.
+  //  - El resto de las operaciones son O(1) (amortizado o esperado).
+  for (const Transaccion& t : transacciones) {
+    size_t dia = _dia_desde_apertura(t._timestamp); // O(1)
+    if (dia >= variaciones.size()) { // O(1)
+      variaciones.resize(dia + 1, 0); // (justificado arriba)
+    }
+    // Se repite el truncado de `_saldo`, transacción por transacción y en
+    // orden de llegada, para que el prefijo coincida con `saldo()`.
+    monto saldo_anterior = saldo; // O(1)
+    saldo = _saldo_luego_de(saldo, t); // O(1)
+    variaciones[dia] += static_cast<int>(saldo - saldo_anterior); // O(1)
+
+    id_billetera billetera_amigo = _conseguir_billetera_amigo(t); // O(1)
+    if (billetera_amigo != 0 && t.destino == billetera_amigo) { // O(1)
+      if (envios[billetera_amigo]++ == 0) { // O(1) esperado
+        destinatarios.push_back(billetera_amigo); // O(1) amortizado
+      }
+      _destinatarios_en_ventana->registrar(billetera_amigo, t._timestamp); // O(1) amortizado
+    }
+  }
+
+  _saldo_por_dia = make_unique<ArbolFenwick>(variaciones, &_memoria.saldo_por_dia); // O(D)
+
+  _billeteras_por_cantidad_de_transacciones.clear(); // O(C)
+  for (id_billetera destinatario : destinatarios) { // O(C) iteraciones
+    _billeteras_por_cantidad_de_transacciones[envios[destinatario]].push_back(destinatario); // O(log C)
+  }
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(T + D + C * log(C))
+}
+
+id_billetera Billetera::_conseguir_billetera_amigo(Transaccion t) const {
   if(t.origen == _id) { // O(1)
     return t.destino; // O(1)
   }
@@ -123,50 +315,57 @@ id_billetera Billetera::_conseguir_billetera_amigo(Transaccion t) {
 }
 
 void Billetera::_actualizar_saldo(Transaccion t) {
+  _saldo = _saldo_luego_de(_saldo, t); // O(1)
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(1)
+}
+
+monto Billetera::_saldo_luego_de(monto saldo, Transaccion t) const {
   // Si envié dinero
   if(t.origen == _id) { // O(1)
-    _saldo -= t.monto; // O(1)
-    return; // O(1)
+    saldo -= t.monto; // O(1)
+    return saldo; // O(1)
   }
   // Si recibí
-  _saldo += t.monto; // O(1)
+  saldo += t.monto; // O(1)
+  return saldo; // O(1)
 
   // COMPLEJIDAD TOTAL DEL MÉTODO: O(1)
   //   - En el peor caso 3 operaciones O(1)
   //   - 3*O(1) = O(1)
 }
 
-void Billetera::_actualizar_saldo_por_dia(Transaccion t) {
-  const timestamp fin_del_dia = Calendario::fin_del_dia(t._timestamp); // O(1)
+void Billetera::_actualizar_saldo_por_dia(Transaccion t, monto saldo_anterior) {
+  TramoTraza tramo("saldo_por_dia"); // O(1)
+  size_t dia = _dia_desde_apertura(t._timestamp); // O(1)
 
-  id_billetera billetera_amigo = _conseguir_billetera_amigo(t); // O(1)
+  // Si la transacción es de un día posterior al último registrado, se agregan
+  // los días intermedios sin movimientos.
+  size_t dias_antes = _saldo_por_dia->tamano(); // O(1)
+  _saldo_por_dia->extender(dia + 1); // O(G + log²(D)), O(1) si no es el día más reciente
+  tramo.argumento("dias_agregados", _saldo_por_dia->tamano() - dias_antes); // O(1)
 
-  // Si es la trx semilla.
-  if (billetera_amigo == 0) { // O(1)
-    _saldo_por_dia[fin_del_dia] = _saldo; // O(1) (esta vacio)
-    return; // O(1)
-  }
-
-  auto it_saldos = _saldo_por_dia.rbegin(); // O(1)
-  const timestamp ultimo_dia_con_saldo = it_saldos->first; // O(1)
+  // La diferencia es módulo 2^32: como entero con signo es lo que cambió.
+  int variacion = static_cast<int>(_saldo - saldo_anterior); // O(1)
+  _saldo_por_dia->sumar(dia, variacion); // O(log D)
 
-  const monto ultimo_saldo = it_saldos->second; // O(1)
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(G + log²(D))
+  //   - 2 operaciones O(1) + O(G + log²(D)) + O(log D)
+  //   - 2*O(1) + O(G + log²(D)) + O(log D) = O(G + log²(D))
+}
 
-  // Complejidad total del ciclo: O((D-1) * log D)
-  //   - O(D-1) iteraciones
-  //   - O(log D) operaciones en cada iteración
-  for (timestamp i = Calendario::dia_siguiente(ultimo_dia_con_saldo); i < fin_del_dia; i = Calendario::dia_siguiente(i)) { // O(D-1) iteraciones.
-    _saldo_por_dia[i] = ultimo_saldo; // O(log D)
+size_t Billetera::_dia_desde_apertura(timestamp t) const {
+  // Las transacciones anteriores a la apertura se cuentan en el día 0.
+  if (t < _dia_de_apertura) { // O(1)
+    return 0; // O(1)
   }
-  
-  _saldo_por_dia[fin_del_dia] = _saldo; // O(log D)
+  return Calendario::dias_entre(_dia_de_apertura, t); // O(1)
 
-  // COMPLEJIDAD TOTAL DEL MÉTODO: O(D log(D))
-  //   - 6 operaciones O(1) + O((D-1) * log D) + O(log D)
-  //   - 6*O(1) + O((D-1) * log D) + O(log D) = O(1) + O(D*log(D)) = O(D*log(D))
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(1)
 }
 
 void Billetera::_actualizar_billeteras_por_cantidad_de_transacciones(Transaccion t) {
+  TramoTraza tramo("destinatarios"); // O(1)
   id_billetera billetera_amigo = _conseguir_billetera_amigo(t); // O(1)
 
   bool encontrado = false; // O(1)
@@ -199,7 +398,7 @@ void Billetera::_actualizar_billeteras_por_cantidad_de_transacciones(Transaccion
   //   - 6*O(1) + O(log C) + O(C) = O(1) + O(log C) + O(C) = max{O(1), O(log C), O(C)} = O(C)
 }
 
-void Billetera::_actualizar_cantidad_transacciones_billetera_amigo(map<int, vector<id_billetera>>::iterator it, id_billetera billetera_amigo, int i) {
+void Billetera::_actualizar_cantidad_transacciones_billetera_amigo(DestinatariosPorCantidad::iterator it, id_billetera billetera_amigo, int i) {
   // Borrar la billetera de su frecuencia.
   it->second[i] = it->second[it->second.size() - 1]; // O(1)
   it->second.pop_back(); // O(1)
@@ -1,10 +1,18 @@
 #ifndef BILLETERA_H
 #define BILLETERA_H
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <scoped_allocator>
 #include <string>
 #include <vector>
 #include "lib.h"
 #include "blockchain.h"
+#include "arbol_fenwick.h"
+#include "frecuencias_ventana.h"
+#include "historial_comprimido.h"
+#include "memoria.h"
 
 using namespace std;
 
@@ -21,16 +29,32 @@ using namespace std;
  *    donde esta fue destino es igual a la clave.
  *  - No hay destinatarios repetidos.
  * 
+ * _dia_de_apertura:
+ *  - Es el timestamp de la transacción semilla.
+ *
+ * _destinatarios_en_ventana:
+ *  - Cuenta las transacciones donde Billetera fue origen con timestamp dentro de los últimos
+ *    `_dias_ventana` días, agrupadas por destinatario.
+ *
  * _saldo_por_dia:
- *  - Las claves del map son finales de días.
- *  - La cantidad de claves en el map es la cantidad de días entre que se abrió Billetera y su última transacción.
- *  - Los valores son todos los días entre la semilla y la última trx.
- *  - Para cada clave, el valor es la suma del monto de todas las transacciones donde Billetera fue destino 
- *  menos la suma del monto de todas las transacciones donde Billetera fue origen hasta el día de la clave.
+ *  - La posición d corresponde al d-ésimo día desde el día de apertura (el día de apertura es la posición 0).
+ *  - La cantidad de posiciones es la cantidad de días entre que se abrió Billetera y el día de su transacción
+ *    con mayor timestamp, inclusive.
+ *  - El valor de la posición d es la suma de lo que cambió `_saldo` con cada transacción de ese día (el monto
+ *    recibido menos el enviado, ya truncado como lo trunca `_saldo`). Las transacciones con timestamp anterior
+ *    a la apertura se cuentan en el día 0.
+ *  - Por lo tanto, el prefijo hasta d es el saldo de Billetera al fin del día d, sin importar el orden en que
+ *    llegaron las transacciones.
  * 
  * _transacciones:
- *  - Listado de todas las transacciones realizadas que involucran a la billetera.
+ *  - Historial (comprimido) de todas las transacciones realizadas que involucran a la billetera.
  *  - Ordenadas en orden de llegada
+ *
+ * _indices_materializados:
+ *  - Si es true, `_saldo_por_dia` y `_destinatarios_en_ventana` no son nulos.
+ *  - Si es false, `_saldo_por_dia` y `_destinatarios_en_ventana` son nulos,
+ *    `_billeteras_por_cantidad_de_transacciones` está vacío, y los invariantes de arriba no valen para
+ *    ellos: se reconstruyen a partir de `_transacciones` en la próxima consulta que los necesite.
  */
 class Billetera {
   public:
@@ -40,6 +64,13 @@ class Billetera {
      */
     Billetera(const id_billetera id, Blockchain* blockchain);
 
+    /**
+     * Los asignadores de sus estructuras cuentan en `_memoria` de esta misma
+     * billetera: no se copia.
+     */
+    Billetera(const Billetera&) = delete;
+    Billetera& operator=(const Billetera&) = delete;
+
     /**
      *  Retorna el id de la billetera, asignado al momento de su creación.
      */
@@ -51,8 +82,17 @@ class Billetera {
      *
      * Este método también es notificado al registrarse la transacción semilla.
      *
-     * Complejidad esperada: O(D*log(D) + C), donde:
+     * Las transacciones pueden llegar fuera de orden: una transacción con
+     * timestamp anterior al de la última se impacta en su día, y todos los
+     * saldos por día posteriores la reflejan.
+     *
+     * Con índices perezosos y la billetera sin índices armados, sólo se
+     * actualizan el saldo y el historial, en O(1) amortizado.
+     *
+     * Complejidad esperada: O(G + log²(D) + C), donde:
      *   - D es la máxima cantidad de días que una billetera estuvo activa
+     *   - G es la cantidad de días sin transacciones entre la transacción y la anterior más reciente
+     *     (O(log(D)) si la transacción no es la más reciente)
      *   - C es la máxima cantidad de destinatarios totales a los que una billetera envió dinero
      */
     void notificar_transaccion(Transaccion t);
@@ -64,6 +104,14 @@ class Billetera {
      */
     monto saldo() const;
 
+    /**
+     * Devuelve la cantidad de transacciones en las que participó la
+     * billetera, incluida la semilla.
+     *
+     * Complejidad esperada: O(1)
+     */
+    unsigned cantidad_transacciones() const;
+
     /**
      * Devuelve el saldo que tenía la billetera hacia fin del día de `t`.
      *
@@ -94,7 +142,77 @@ class Billetera {
      */
     vector<id_billetera> detinatarios_mas_frecuentes(int k) const;
 
+    /**
+     * Igual que `detinatarios_mas_frecuentes`, pero contando sólo las
+     * transacciones de los últimos N días (incluyendo el día actual), donde N
+     * es el largo de la ventana (VENTANA_DESTINATARIOS por defecto).
+     *
+     * Las transacciones que vencieron desde la última consulta se descuentan
+     * en este momento; ese costo se amortiza contra su registro. Como
+     * modifica la ventana, no es seguro llamarlo desde varios hilos a la vez.
+     *
+     * Complejidad esperada: O(k) amortizado
+     */
+    vector<id_billetera> destinatarios_mas_frecuentes_en_ventana(int k) const;
+
+    /**
+     * Cambia el largo de la ventana de `destinatarios_mas_frecuentes_en_ventana`
+     * y recalcula las cantidades a partir de las transacciones de la billetera.
+     *
+     * Complejidad esperada: O(T), donde T es la cantidad de transacciones de la billetera
+     */
+    void fijar_ventana_destinatarios(unsigned dias);
+
+    /**
+     * Indica si los índices de `saldo_al_fin_del_dia` y de los destinatarios
+     * más frecuentes están armados. Con índices perezosos (ver
+     * `Blockchain::fijar_indices_perezosos`) se arman en la primera consulta
+     * y desde ahí se mantienen con cada transacción.
+     *
+     * Sin índices armados, las consultas que los usan los arman (modifican
+     * la billetera), así que no es seguro hacerlas desde varios hilos a la
+     * vez. Con índices armados y sin índices perezosos, las consultas sólo
+     * leen, salvo `destinatarios_mas_frecuentes_en_ventana`, que siempre
+     * descuenta las transacciones vencidas de la ventana.
+     */
+    bool indices_materializados() const;
+
+    /**
+     * Descarta los índices. Hasta la próxima consulta que los necesite, la
+     * billetera sólo mantiene su saldo y su historial.
+     *
+     * Complejidad esperada: O(D + C)
+     */
+    void liberar_indices();
+
+    /**
+     * Momento de la última consulta que usó los índices, o 0 si nunca se
+     * consultaron. Sólo se anota con índices perezosos.
+     */
+    timestamp ultima_consulta() const;
+
+    /**
+     * Devuelve los bytes que ocupa la billetera, por estructura.
+     *
+     * Complejidad esperada: O(1)
+     */
+    MemoriaBilletera memoria() const;
+
+    /** Largo por defecto de la ventana de destinatarios, en días. */
+    static const unsigned VENTANA_DESTINATARIOS = 7;
+
   private:
+    typedef vector<id_billetera, AsignadorContado<id_billetera>> Destinatarios;
+
+    /**
+     * El asignador "scoped" le pasa el contador del mapa a los vectores que
+     * crea, así que los vectores también cuentan en `_memoria.destinatarios`.
+     */
+    typedef map<int, Destinatarios, less<int>, scoped_allocator_adaptor<AsignadorContado<pair<const int, Destinatarios>>>> DestinatariosPorCantidad;
+
+    /** La blockchain arma las billeteras directamente al cargar un listado. */
+    friend class Blockchain;
+
     /** El id de la billetera */
     const id_billetera _id;
 
@@ -104,26 +222,116 @@ class Billetera {
     /** Saldo actual de la billetera */
     monto _saldo;
 
-    /** Mapa de cantidad de interacciones y billeteras asociadas destinatarias */
-    map<int, vector<id_billetera>> _billeteras_por_cantidad_de_transacciones;
+    /**
+     * Contadores de los asignadores de cada estructura. Se declara antes que
+     * las estructuras porque tiene que construirse antes y destruirse
+     * después. Mutable porque los índices se materializan al consultar.
+     */
+    mutable MemoriaBilletera _memoria;
+
+    /**
+     * Mapa de cantidad de interacciones y billeteras asociadas destinatarias.
+     * Mutable porque se materializa al consultar.
+     */
+    mutable DestinatariosPorCantidad _billeteras_por_cantidad_de_transacciones;
+
+    /** Largo de la ventana de destinatarios, en días. */
+    unsigned _dias_ventana;
 
-    /** Saldos por dia */
-    map<timestamp, monto> _saldo_por_dia;
+    /**
+     * Cantidad de envíos por destinatario en la ventana. Se vence al
+     * consultar, por eso es mutable. Nula sin índices armados, así una
+     * billetera fría no paga ni la estructura vacía.
+     */
+    mutable unique_ptr<FrecuenciasVentana> _destinatarios_en_ventana;
+
+    /** Timestamp de la transacción semilla */
+    timestamp _dia_de_apertura;
+
+    /**
+     * Variación de saldo de cada día desde la apertura. Mutable y nula sin
+     * índices, igual que la ventana.
+     */
+    mutable unique_ptr<ArbolFenwick> _saldo_por_dia;
     
-    /** Listado de todas las transacciones realizadas que involucran a la billetera*/
-    list<Transaccion> _transacciones;
+    /** Historial de todas las transacciones realizadas que involucran a la billetera*/
+    HistorialComprimido _transacciones;
+
+    /** Si los índices derivados del historial están armados */
+    mutable bool _indices_materializados;
+
+    /**
+     * Momento de la última consulta a los índices, con índices perezosos.
+     * Atómico para que dos consultas concurrentes a una billetera con índices
+     * armados no compitan al anotarlo.
+     */
+    mutable atomic<timestamp> _ultima_consulta;
 
     /** Métodos auxiliares */
 
-    id_billetera _conseguir_billetera_amigo(Transaccion t);
+    /**
+     * Carga de una vez las transacciones de una billetera recién creada, en
+     * orden de llegada y empezando por la semilla. Equivale a notificarlas una
+     * por una, pero arma los índices sin pasar por las actualizaciones
+     * incrementales.
+     *
+     * Complejidad esperada: O(T + D + C * log(C))
+     */
+    void _cargar(const vector<Transaccion>& transacciones);
+
+    /**
+     * Recalcula `_saldo_por_dia`, `_billeteras_por_cantidad_de_transacciones`
+     * y `_destinatarios_en_ventana` a partir de las transacciones dadas.
+     *
+     * Complejidad esperada: O(T + D + C * log(C))
+     */
+    void _construir_indices(const vector<Transaccion>& transacciones) const;
+
+    /**
+     * Arma los índices a partir del historial si no estaban armados, y anota
+     * el momento de la consulta si los índices son perezosos.
+     *
+     * Complejidad esperada: O(1), u O(T + D + C * log(C)) si no estaban armados
+     */
+    void _materializar_indices() const;
+
+    /**
+     * Pide a la caché los campos que leen `saldo` y `saldo_al_fin_del_dia`.
+     * Los usa la blockchain en las consultas por lote.
+     *
+     * Complejidad: O(1)
+     */
+    void _anticipar() const;
+
+    /**
+     * Pide a la caché los nodos de `_saldo_por_dia` que lee
+     * `saldo_al_fin_del_dia(t)`, si los índices están armados.
+     *
+     * Complejidad: O(log(D))
+     */
+    void _anticipar_saldo_al_fin_del_dia(timestamp t) const;
+
+    id_billetera _conseguir_billetera_amigo(Transaccion t) const;
     
     void _actualizar_saldo(Transaccion t);
 
-    void _actualizar_saldo_por_dia(Transaccion t);
+    /**
+     * Saldo que queda al impactar `t` sobre `saldo`, con el mismo truncado
+     * que `_saldo`.
+     */
+    monto _saldo_luego_de(monto saldo, Transaccion t) const;
+
+    /**
+     * Suma al día de `t` lo que cambió `_saldo` al impactarla, que antes
+     * valía `saldo_anterior`.
+     */
+    void _actualizar_saldo_por_dia(Transaccion t, monto saldo_anterior);
+
+    size_t _dia_desde_apertura(timestamp t) const;
 
     void _actualizar_billeteras_por_cantidad_de_transacciones(Transaccion t);
 
-    void _actualizar_cantidad_transacciones_billetera_amigo(map<int, vector<id_billetera>>::iterator it, id_billetera billetera_amigo, int i);
+    void _actualizar_cantidad_transacciones_billetera_amigo(DestinatariosPorCantidad::iterator it, id_billetera billetera_amigo, int i);
 };
 
 #endif
@@ -1,33 +1,182 @@
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <queue>
+#include <thread>
 
 #include "calendario.h"
 #include "blockchain.h"
 #include "billetera.h"
+#include "registro_persistente.h"
+#include "grafo_transacciones.h"
+#include "replica_saldos.h"
+#include "paralelo.h"
+#include "traza.h"
 
 using namespace std;
 
-Blockchain::Blockchain() {
-  _transacciones = {};
-  _billeteras = {};
+Blockchain::Blockchain()
+  : _bytes_transacciones(0)
+  , _bytes_registro(0)
+  , _transacciones(AsignadorContado<Transaccion>(&_bytes_transacciones))
+  , _billeteras(AsignadorContado<pair<const id_billetera, Billetera*>>(&_bytes_registro))
+  , _indice_billeteras(AsignadorContado<pair<id_billetera, Billetera*>>(&_bytes_registro)) {
+  _registro = nullptr;
+  _ultimo_ticket = 0;
+  _replica = nullptr;
+  _indices_perezosos = false;
 
   // sumo 1 porque el id 0 está reservado para las transacciones de saldo
   // inicial.
   _siguiente_id_billetera = static_cast<unsigned int>(rand()) + 1;
 }
 
+Blockchain::Blockchain(const vector<Transaccion>& transacciones, unsigned hilos, bool indices_perezosos) : Blockchain() {
+  hilos = hilos_a_usar(hilos);
+  // Antes de crear las billeteras, que lo leen al construirse.
+  _indices_perezosos = indices_perezosos;
+
+  // El reparto sólo lee el listado de entrada, así que el listado propio se
+  // copia en otro hilo mientras tanto. Si algo lanza una excepción antes de
+  // esperarlo, la guarda lo espera igual.
+  HiloUnido copia([this, &transacciones]() {
+    _transacciones.assign(transacciones.begin(), transacciones.end());
+  });
+
+  // Las billeteras son los destinos de las semillas.
+  vector<id_billetera> ids;
+  for (const Transaccion& t : transacciones) {
+    if (t.origen == 0) {
+      ids.push_back(t.destino);
+    }
+  }
+  ordenar_en_paralelo(ids, hilos, less<id_billetera>());
+  ids.erase(unique(ids.begin(), ids.end()), ids.end());
+
+  // Una blockchain asigna ids consecutivos, así que normalmente la posición
+  // de cada id se puede buscar en una tabla directa; si los ids están muy
+  // dispersos se usa búsqueda binaria.
+  vector<size_t> tabla;
+  if (!ids.empty() && ids.back() - ids.front() < 4 * ids.size()) {
+    tabla.assign(ids.back() - ids.front() + 1, ids.size());
+    for (size_t b = 0; b < ids.size(); b++) {
+      tabla[ids[b] - ids.front()] = b;
+    }
+  }
+  auto posicion = [&ids, &tabla](id_billetera id) {
+    if (!tabla.empty()) {
+      return id >= ids.front() && id <= ids.back() ? tabla[id - ids.front()] : ids.size();
+    }
+    auto it = lower_bound(ids.begin(), ids.end(), id);
+    return it != ids.end() && *it == id ? size_t(it - ids.begin()) : ids.size();
+  };
+
+  // Reparto por billetera (counting sort): primero se cuenta cuántas
+  // transacciones tiene cada una y después cada transacción se escribe en el
+  // rango de cada billetera que participa.
+  vector<atomic<size_t>> cantidades(ids.size());
+  para_cada_bloque(transacciones.size(), hilos, [&](unsigned, size_t desde, size_t hasta) {
+    for (size_t i = desde; i < hasta; i++) {
+      const Transaccion& t = transacciones[i];
+      size_t b = t.origen != 0 ? posicion(t.origen) : ids.size();
+      if (b < ids.size()) {
+        cantidades[b].fetch_add(1, memory_order_relaxed);
+      }
+      b = posicion(t.destino);
+      if (b < ids.size()) {
+        cantidades[b].fetch_add(1, memory_order_relaxed);
+      }
+    }
+  });
+
+  vector<size_t> inicios(ids.size() + 1, 0);
+  for (size_t b = 0; b < ids.size(); b++) {
+    inicios[b + 1] = inicios[b] + cantidades[b].load(memory_order_relaxed);
+    cantidades[b].store(inicios[b], memory_order_relaxed);
+  }
+
+  vector<size_t> indices(inicios.back());
+  para_cada_bloque(transacciones.size(), hilos, [&](unsigned, size_t desde, size_t hasta) {
+    for (size_t i = desde; i < hasta; i++) {
+      const Transaccion& t = transacciones[i];
+      size_t b = t.origen != 0 ? posicion(t.origen) : ids.size();
+      if (b < ids.size()) {
+        indices[cantidades[b].fetch_add(1, memory_order_relaxed)] = i;
+      }
+      b = posicion(t.destino);
+      if (b < ids.size()) {
+        indices[cantidades[b].fetch_add(1, memory_order_relaxed)] = i;
+      }
+    }
+  });
+
+  // Cada hilo toma billeteras de a tandas, para que unas pocas billeteras con
+  // muchas transacciones no dejen al resto de los hilos sin trabajo.
+  const size_t TANDA = 64;
+  vector<Billetera*> billeteras(ids.size());
+  atomic<size_t> siguiente_tanda(0);
+  para_cada_bloque(hilos, hilos, [&](unsigned, size_t, size_t) {
+    vector<Transaccion> propias;
+    for (size_t tanda = siguiente_tanda.fetch_add(TANDA); tanda < ids.size(); tanda = siguiente_tanda.fetch_add(TANDA)) {
+      for (size_t b = tanda; b < min(tanda + TANDA, ids.size()); b++) {
+        // Dentro del rango de la billetera, las transacciones quedaron en el
+        // orden en que las escribieron los hilos: se restaura el del listado.
+        sort(indices.begin() + inicios[b], indices.begin() + inicios[b + 1]);
+
+        propias.clear();
+        for (size_t j = inicios[b]; j < inicios[b + 1]; j++) {
+          propias.push_back(transacciones[indices[j]]);
+        }
+
+        billeteras[b] = new Billetera(ids[b], this);
+        billeteras[b]->_cargar(propias);
+      }
+    }
+  });
+
+  for (size_t b = 0; b < ids.size(); b++) {
+    _billeteras.emplace_hint(_billeteras.end(), ids[b], billeteras[b]);
+    _indice_billeteras.emplace_back(ids[b], billeteras[b]);
+  }
+  if (!ids.empty()) {
+    _siguiente_id_billetera = ids.back() + 1;
+  }
+
+  copia.esperar();
+}
+
+Blockchain::Blockchain(const string& ruta_registro, unsigned hilos, bool indices_perezosos)
+  : Blockchain(RegistroPersistente::leer(ruta_registro), hilos, indices_perezosos) {
+}
+
 Billetera* Blockchain::abrir_billetera() {
-  Billetera * billetera = new Billetera(_siguiente_id_billetera, this);
-  _billeteras[billetera->id()] = billetera;
-  _siguiente_id_billetera++;
+  if (_registro != nullptr && _registro->fallo_escritura()) {
+    return nullptr;
+  }
 
-  Transaccion transaccion = {0, billetera->id(), SALDO_INICIAL, Calendario::tiempo_actual()};
-  _transacciones.push_back(transaccion);
-  billetera->notificar_transaccion(transaccion);
+  Billetera * billetera = _registrar_billetera(_siguiente_id_billetera, Calendario::tiempo_actual());
+  _siguiente_id_billetera++;
 
-  return billetera;
+  return esperar_durable(_ultimo_ticket) ? billetera : nullptr;
 }
 
 bool Blockchain::agregar_transaccion(Billetera* origen, id_billetera destino, double monto) {
+  return agregar_transaccion(origen, destino, monto, Calendario::tiempo_actual());
+}
+
+bool Blockchain::agregar_transaccion(Billetera* origen, id_billetera destino, double monto, timestamp momento) {
+  return esperar_durable(agregar_sin_esperar(origen, destino, monto, momento));
+}
+
+unsigned long long Blockchain::agregar_sin_esperar(Billetera* origen, id_billetera destino, double monto) {
+  return agregar_sin_esperar(origen, destino, monto, Calendario::tiempo_actual());
+}
+
+unsigned long long Blockchain::agregar_sin_esperar(Billetera* origen, id_billetera destino, double monto, timestamp momento) {
+  TramoTraza tramo("agregar_transaccion");
+  tramo.argumento("origen", origen->id());
+  tramo.argumento("destino", destino);
+
   auto origen_it = _billeteras.find(origen->id());
   auto destino_it = _billeteras.find(destino);
 
@@ -35,27 +184,117 @@ bool Blockchain::agregar_transaccion(Billetera* origen, id_billetera destino, do
   bool origen_valido = origen_it != _billeteras.end() && origen_it->second == origen;
   bool destino_valido = destino_it != _billeteras.end();
   bool saldo_suficiente = calcular_saldo(origen) >= monto;
+  // Con el registro ya fallado la transacción nunca sería durable: se
+  // rechaza antes de impactarla.
+  bool registro_sano = _registro == nullptr || !_registro->fallo_escritura();
 
-  bool transaccion_aprobada = billeteras_distintas && origen_valido && destino_valido && saldo_suficiente;
+  bool transaccion_aprobada = billeteras_distintas && origen_valido && destino_valido && saldo_suficiente && registro_sano;
 
   if (!transaccion_aprobada) {
+    return 0;
+  }
+
+  Transaccion transaccion = {origen->id(), destino, monto, momento};
+  _impactar_transaccion(transaccion);
+
+  return _ultimo_ticket;
+}
+
+bool Blockchain::esperar_durable(unsigned long long ticket) {
+  if (ticket == 0) {
     return false;
   }
+  return _registro == nullptr || _registro->esperar(ticket);
+}
+
+Billetera* Blockchain::billetera(id_billetera id) const {
+  auto it = _billeteras.find(id);
+  return it == _billeteras.end() ? nullptr : it->second;
+}
 
-  Transaccion transaccion = {origen->id(), destino, monto, Calendario::tiempo_actual()};
+bool Blockchain::saldos(const vector<id_billetera>& ids, vector<monto>& salida) const {
+  vector<const Billetera*> billeteras;
+  bool todas = _resolver(ids, billeteras);
 
-  _transacciones.push_back(transaccion);
-  origen_it->second->notificar_transaccion(transaccion);
-  destino_it->second->notificar_transaccion(transaccion);
+  salida.resize(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    if (i + DISTANCIA_ANTICIPACION < ids.size() && billeteras[i + DISTANCIA_ANTICIPACION] != nullptr) {
+      billeteras[i + DISTANCIA_ANTICIPACION]->_anticipar();
+    }
+    salida[i] = billeteras[i] != nullptr ? billeteras[i]->saldo() : 0;
+  }
+
+  return todas;
+}
+
+bool Blockchain::saldos_al_fin_del_dia(const vector<id_billetera>& ids, const vector<timestamp>& momentos, vector<monto>& salida) const {
+  vector<const Billetera*> billeteras;
+  bool todas = _resolver(ids, billeteras);
 
-  return true;
+  // Dos etapas de anticipación: primero se pide la billetera, y cuando ya
+  // debería estar en caché se la lee para pedir los nodos del árbol.
+  salida.resize(ids.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    size_t billetera_a_pedir = i + 2 * DISTANCIA_ANTICIPACION;
+    if (billetera_a_pedir < ids.size() && billeteras[billetera_a_pedir] != nullptr) {
+      billeteras[billetera_a_pedir]->_anticipar();
+    }
+    size_t arbol_a_pedir = i + DISTANCIA_ANTICIPACION;
+    if (arbol_a_pedir < ids.size() && billeteras[arbol_a_pedir] != nullptr) {
+      billeteras[arbol_a_pedir]->_anticipar_saldo_al_fin_del_dia(momentos[arbol_a_pedir]);
+    }
+    salida[i] = billeteras[i] != nullptr ? billeteras[i]->saldo_al_fin_del_dia(momentos[i]) : 0;
+  }
+
+  return todas;
 }
 
-const list<Transaccion>& Blockchain::transacciones() {
+bool Blockchain::saldos_al_fin_del_dia(const vector<id_billetera>& ids, timestamp momento, vector<monto>& salida) const {
+  return saldos_al_fin_del_dia(ids, vector<timestamp>(ids.size(), momento), salida);
+}
+
+const ListaTransacciones& Blockchain::transacciones() {
   return _transacciones;
 }
 
+void Blockchain::publicar_saldos_en(ReplicaSaldos* replica) {
+  _replica = replica;
+}
+
+GrafoTransacciones Blockchain::grafo(unsigned hilos) const {
+  return GrafoTransacciones(_transacciones, hilos);
+}
+
+void Blockchain::persistir_en(RegistroPersistente* registro) {
+  _registro = registro;
+}
+
+void Blockchain::fijar_indices_perezosos(bool perezosos) {
+  _indices_perezosos = perezosos;
+}
+
+bool Blockchain::indices_perezosos() const {
+  return _indices_perezosos;
+}
+
+size_t Blockchain::liberar_indices_inactivos(timestamp consultadas_antes_de) {
+  size_t liberadas = 0;
+
+  for (auto it = _billeteras.begin(); it != _billeteras.end(); ++it) {
+    Billetera* billetera = it->second;
+    if (billetera->indices_materializados() && billetera->ultima_consulta() < consultadas_antes_de) {
+      billetera->liberar_indices();
+      liberadas++;
+    }
+  }
+
+  return liberadas;
+}
+
 monto Blockchain::calcular_saldo(const Billetera* billetera) const {
+  TramoTraza tramo("calcular_saldo");
+  tramo.argumento("transacciones", _transacciones.size());
+
   monto resultado = 0;
 
   for (auto it = _transacciones.begin(); it != _transacciones.end(); ++it) {
@@ -70,6 +309,118 @@ monto Blockchain::calcular_saldo(const Billetera* billetera) const {
   return resultado;
 }
 
+Billetera* Blockchain::_registrar_billetera(id_billetera id, timestamp momento) {
+  Billetera * billetera = new Billetera(id, this);
+  _billeteras[billetera->id()] = billetera;
+
+  auto posicion = upper_bound(_indice_billeteras.begin(), _indice_billeteras.end(), make_pair(id, billetera));
+  _indice_billeteras.insert(posicion, make_pair(id, billetera));
+
+  Transaccion transaccion = {0, billetera->id(), SALDO_INICIAL, momento};
+  _impactar_transaccion(transaccion);
+
+  return billetera;
+}
+
+void Blockchain::_impactar_transaccion(Transaccion transaccion) {
+  _transacciones.push_back(transaccion);
+
+  // Sólo se encola: quien llama decide si espera a que sea durable.
+  if (_registro != nullptr) {
+    _ultimo_ticket = _registro->agregar(transaccion);
+  } else {
+    _ultimo_ticket++;
+  }
+
+  // En una blockchain fragmentada alguna de las dos billeteras puede vivir en
+  // otro fragmento: sólo notificamos a las que están registradas acá.
+  if (transaccion.origen != 0) {
+    auto origen_it = _billeteras.find(transaccion.origen);
+    if (origen_it != _billeteras.end()) {
+      origen_it->second->notificar_transaccion(transaccion);
+      _publicar_saldo(origen_it->second, transaccion);
+    }
+  }
+
+  auto destino_it = _billeteras.find(transaccion.destino);
+  if (destino_it != _billeteras.end()) {
+    destino_it->second->notificar_transaccion(transaccion);
+    _publicar_saldo(destino_it->second, transaccion);
+  }
+}
+
+void Blockchain::_publicar_saldo(const Billetera* billetera, Transaccion transaccion) {
+  if (_replica == nullptr) {
+    return;
+  }
+  _replica->publicar(billetera->id(), billetera->saldo(), transaccion._timestamp, billetera->cantidad_transacciones());
+}
+
+bool Blockchain::_resolver(const vector<id_billetera>& ids, vector<const Billetera*>& billeteras) const {
+  billeteras.assign(ids.size(), nullptr);
+  if (_indice_billeteras.empty()) {
+    return ids.empty();
+  }
+
+  // Búsqueda binaria sin saltos: en cada nivel el rango de cada búsqueda se
+  // reduce a la mitad, y la posición que va a leer en el próximo nivel ya se
+  // conoce, así que se pide antes de pasar a la siguiente búsqueda.
+  vector<size_t> bases(ids.size(), 0);
+  for (size_t largo = _indice_billeteras.size(); largo > 1; ) {
+    size_t mitad = largo / 2;
+    size_t siguiente_mitad = (largo - mitad) / 2;
+    for (size_t i = 0; i < ids.size(); i++) {
+      if (_indice_billeteras[bases[i] + mitad].first <= ids[i]) {
+        bases[i] += mitad;
+      }
+      anticipar_lectura(&_indice_billeteras[bases[i] + siguiente_mitad]);
+    }
+    largo -= mitad;
+  }
+
+  bool todas = true;
+  for (size_t i = 0; i < ids.size(); i++) {
+    if (_indice_billeteras[bases[i]].first == ids[i]) {
+      billeteras[i] = _indice_billeteras[bases[i]].second;
+    } else {
+      todas = false;
+    }
+  }
+
+  return todas;
+}
+
+Blockchain::ReporteMemoria Blockchain::memoria(size_t cantidad_mas_pesadas) const {
+  ReporteMemoria reporte;
+  reporte.transacciones = _bytes_transacciones;
+  reporte.registro_billeteras = _bytes_registro;
+
+  // Las más pesadas se eligen con un heap de mínimo de a lo sumo N
+  // elementos: la raíz es la más liviana de las candidatas.
+  typedef pair<size_t, id_billetera> Candidata;
+  priority_queue<Candidata, vector<Candidata>, greater<Candidata>> candidatas;
+  for (auto it = _billeteras.begin(); it != _billeteras.end(); ++it) {
+    size_t total = it->second->memoria().total();
+    reporte.billeteras += it->second->memoria();
+
+    if (candidatas.size() < cantidad_mas_pesadas) {
+      candidatas.push({total, it->first});
+    } else if (cantidad_mas_pesadas > 0 && candidatas.top().first < total) {
+      candidatas.pop();
+      candidatas.push({total, it->first});
+    }
+  }
+
+  while (!candidatas.empty()) {
+    id_billetera id = candidatas.top().second;
+    reporte.mas_pesadas.push_back({id, _billeteras.at(id)->memoria()});
+    candidatas.pop();
+  }
+  reverse(reporte.mas_pesadas.begin(), reporte.mas_pesadas.end());
+
+  return reporte;
+}
+
 Blockchain::~Blockchain() {
   auto it = this->_billeteras.begin();
   while (it != this->_billeteras.end()) {
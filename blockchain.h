@@ -4,23 +4,81 @@
 #include <list>
 #include <map>
 #include <cstdlib>
+#include <string>
+#include <vector>
 
 #include "lib.h"
+#include "memoria.h"
 
 using namespace std;
 
 class Billetera;
+class RegistroPersistente;
+class GrafoTransacciones;
+class ReplicaSaldos;
 
 class Blockchain {
   public:
+    /** Bytes ocupados por la blockchain y sus billeteras, por estructura. */
+    struct ReporteMemoria {
+      /** Listado de transacciones. */
+      size_t transacciones = 0;
+
+      /** Registro de billeteras (el mapa y el índice ordenado por id). */
+      size_t registro_billeteras = 0;
+
+      /** Suma de todas las billeteras, por estructura. */
+      MemoriaBilletera billeteras;
+
+      /** Las billeteras que más ocupan, de mayor a menor, con su detalle. */
+      vector<pair<id_billetera, MemoriaBilletera>> mas_pesadas;
+
+      size_t total() const {
+        return transacciones + registro_billeteras + billeteras.total();
+      }
+    };
+
     /** Constructor */
     Blockchain();
 
+    /**
+     * Construye la blockchain a partir de un listado de transacciones ya
+     * validado (por ejemplo, el de otra blockchain), sin volver a validarlo.
+     *
+     * Las billeteras son los destinos de las transacciones semilla (origen 0).
+     * Las transacciones se reparten por billetera y cada billetera arma su
+     * historial e índices en paralelo, usando `hilos` hilos (0 = todos los
+     * núcleos). Las transacciones que involucran ids sin semilla sólo quedan
+     * en el listado.
+     *
+     * Las billeteras que se abran después reciben ids mayores al mayor id
+     * cargado.
+     *
+     * Con `indices_perezosos` la blockchain queda en ese modo (ver
+     * `fijar_indices_perezosos`) y las billeteras cargadas sólo arman saldo e
+     * historial: sus índices se arman recién cuando se las consulta.
+     *
+     * Complejidad: O(T * log(B) / H + T + B * log(B)), donde H es la cantidad
+     * de hilos
+     */
+    explicit Blockchain(const vector<Transaccion>& transacciones, unsigned hilos = 0, bool indices_perezosos = false);
+
+    /**
+     * Igual que el constructor anterior, pero lee las transacciones de un
+     * archivo escrito por un RegistroPersistente.
+     */
+    explicit Blockchain(const string& ruta_registro, unsigned hilos = 0, bool indices_perezosos = false);
+
     /**
      * Registra una billetera en la blockchain y devuelve un puntero a la misma.
      *
      * Todas las billeteras tienen un saldo inicial de 100 unidades.
      *
+     * Si hay un registro persistente, vuelve recién cuando la transacción
+     * semilla es durable. Devuelve nullptr si el registro falló: sin abrir la
+     * billetera si ya había fallado antes, o con la billetera abierta en
+     * memoria pero sin semilla durable si falló la escritura de su grupo.
+     *
      * Complejidad: misma que agregar_transacción.
      */
     Billetera* abrir_billetera();
@@ -36,16 +94,137 @@ class Blockchain {
      *
      * Devuelve `true` si y sólo si la transacción se registró con éxito.
      *
+     * Si hay un registro persistente, vuelve recién cuando la transacción es
+     * durable, y la rechaza sin impactarla si el registro ya había fallado.
+     * Si falla la escritura del grupo de esta misma transacción devuelve
+     * `false` aunque ya quedó impactada en memoria: para distinguir ese caso
+     * hay que usar `agregar_sin_esperar` y `esperar_durable`.
+     *
+     * Equivale a `esperar_durable(agregar_sin_esperar(...))`: quien agrega
+     * varias transacciones seguidas y no necesita cada resultado en el
+     * momento puede esperar sólo la última, así se escriben en un mismo grupo.
+     *
      * Complejidad: O(log(B) + T + NT), donde NT es la complejidad del método notificar_transaccion de la clase Billetera
      */
     bool agregar_transaccion(Billetera* origen, id_billetera destino, double monto);
 
+    /**
+     * Igual que `agregar_transaccion`, pero con el timestamp dado en lugar del
+     * tiempo actual. Se usa para ingerir transacciones de un feed replicado,
+     * que pueden llegar fuera de orden (con timestamp anterior al de
+     * transacciones ya registradas).
+     *
+     * Complejidad: misma que agregar_transaccion.
+     */
+    bool agregar_transaccion(Billetera* origen, id_billetera destino, double monto, timestamp momento);
+
+    /**
+     * Valida e impacta la transacción igual que `agregar_transaccion`, pero
+     * sin esperar a que sea durable. Devuelve 0 si la rechazó (sin impactarla)
+     * o, si la impactó, un ticket distinto de 0 para `esperar_durable`.
+     *
+     * Complejidad: misma que agregar_transaccion.
+     */
+    unsigned long long agregar_sin_esperar(Billetera* origen, id_billetera destino, double monto);
+
+    unsigned long long agregar_sin_esperar(Billetera* origen, id_billetera destino, double monto, timestamp momento);
+
+    /**
+     * Bloquea hasta que la transacción del ticket y todas las anteriores son
+     * durables. Devuelve `false` si el ticket es 0 o si falló la escritura.
+     * Sin registro persistente vuelve enseguida.
+     */
+    bool esperar_durable(unsigned long long ticket);
+
+    /**
+     * Devuelve la billetera registrada con el id dado, o nullptr si no hay
+     * ninguna.
+     *
+     * Complejidad: O(log(B))
+     */
+    Billetera* billetera(id_billetera id) const;
+
+    /**
+     * Consulta por lote del saldo actual de las billeteras `ids`: deja en
+     * `salida[i]` el saldo de `ids[i]`, o 0 si no está registrada. Devuelve
+     * `true` si y sólo si estaban todas registradas.
+     *
+     * Mientras procesa una billetera ya le pide a la caché los datos de las
+     * siguientes, de modo que los accesos a memoria de distintas billeteras se
+     * solapan en lugar de esperarse uno a otro.
+     *
+     * Complejidad: O(k * log(B)), donde k es la cantidad de ids
+     */
+    bool saldos(const vector<id_billetera>& ids, vector<monto>& salida) const;
+
+    /**
+     * Consulta por lote de `saldo_al_fin_del_dia`: deja en `salida[i]` el
+     * saldo de `ids[i]` al fin del día de `momentos[i]`, o 0 si no está
+     * registrada. `ids` y `momentos` deben tener el mismo largo. Devuelve
+     * `true` si y sólo si estaban todas registradas.
+     *
+     * Complejidad: O(k * (log(B) + log(D))), más lo que cueste materializar
+     * los índices de las billeteras que no los tengan armados
+     */
+    bool saldos_al_fin_del_dia(const vector<id_billetera>& ids, const vector<timestamp>& momentos, vector<monto>& salida) const;
+
+    /**
+     * Igual que la anterior, con el mismo momento para todas las billeteras.
+     */
+    bool saldos_al_fin_del_dia(const vector<id_billetera>& ids, timestamp momento, vector<monto>& salida) const;
+
     /**
      * Lista de todas las transacciones registradas.
      *
      * Complejidad: O(1), usando una referencia no modificable.
      */
-    const list<Transaccion>& transacciones();
+    const ListaTransacciones& transacciones();
+
+    /**
+     * Construye el grafo de transferencias entre billeteras a partir del
+     * listado de transacciones, usando `hilos` hilos (0 = todos los núcleos).
+     *
+     * Complejidad: O(T * log(T) / H + T)
+     */
+    GrafoTransacciones grafo(unsigned hilos = 0) const;
+
+    /**
+     * Hace que todas las transacciones que se impacten de acá en más se
+     * escriban en `registro`. La blockchain no toma posesión del registro.
+     */
+    void persistir_en(RegistroPersistente* registro);
+
+    /**
+     * Hace que, con cada transacción que se impacte de acá en más, se
+     * publique en `replica` el estado de las billeteras involucradas. La
+     * blockchain no toma posesión de la réplica. Si la réplica se llena, las
+     * billeteras que no entran no se publican y se cuentan en
+     * `ReplicaSaldos::descartadas`.
+     */
+    void publicar_saldos_en(ReplicaSaldos* replica);
+
+    /**
+     * Con `true`, las billeteras que se abran de acá en más no mantienen los
+     * índices de `saldo_al_fin_del_dia` ni de destinatarios más frecuentes
+     * hasta que se los consulta por primera vez: al notificarlas sólo
+     * actualizan su saldo y su historial. Conviene cuando la mayoría de las
+     * billeteras nunca se consulta.
+     */
+    void fijar_indices_perezosos(bool perezosos);
+
+    /** Indica si las billeteras nuevas arman sus índices recién al consultarlas. */
+    bool indices_perezosos() const;
+
+    /**
+     * Descarta los índices de las billeteras que no los consultan desde antes
+     * de `consultadas_antes_de` (o que nunca los consultaron). Se vuelven a
+     * armar en la próxima consulta. Devuelve la cantidad de billeteras que
+     * liberaron sus índices. Sin índices perezosos no se registran las
+     * consultas, así que se liberan todas.
+     *
+     * Complejidad: O(B + suma de D + C de las billeteras liberadas)
+     */
+    size_t liberar_indices_inactivos(timestamp consultadas_antes_de);
 
     /**
      * Calcula el saldo actual de una billetera, recorriendo toda la lista de
@@ -55,27 +234,129 @@ class Blockchain {
      */
     monto calcular_saldo(const Billetera* billetera) const;
 
+    /**
+     * Reporte de la memoria ocupada: totales por estructura de la blockchain
+     * y de todas sus billeteras, y el detalle de las
+     * `cantidad_mas_pesadas` billeteras que más ocupan.
+     *
+     * Los bytes los cuentan los asignadores de cada estructura, así que
+     * incluyen la capacidad reservada y no usada, pero no el overhead del
+     * asignador de memoria del sistema.
+     *
+     * Complejidad: O(B * log(N)), donde N es `cantidad_mas_pesadas`
+     */
+    ReporteMemoria memoria(size_t cantidad_mas_pesadas = 10) const;
+
     /**
      * Destructor.
      * Libera la memoria dinámica pedida por la blockchain al crear billeteras.
      */
     ~Blockchain();
 
+    /**
+     * Los asignadores del listado y del registro cuentan en contadores de
+     * esta misma blockchain, y es dueña de sus billeteras: no se copia.
+     */
+    Blockchain(const Blockchain&) = delete;
+    Blockchain& operator=(const Blockchain&) = delete;
+
   private:
+    /**
+     * La blockchain fragmentada usa una Blockchain por fragmento y necesita
+     * registrar billeteras con ids elegidos por ella e impactar transacciones
+     * ya validadas.
+     */
+    friend class BlockchainFragmentada;
+
+    /**
+     * Contadores de los asignadores del listado y del registro de
+     * billeteras. Se declaran antes que las estructuras que cuentan.
+     */
+    size_t _bytes_transacciones;
+    size_t _bytes_registro;
+
     /** Listado de todas las transacciones realizadas */
-    list<Transaccion> _transacciones;
+    ListaTransacciones _transacciones;
 
     /**
      * Registro de todas las billeteras que fueron abiertas. Se mantiene un
      * puntero a cada una para poder notificarlas cuando hay una transacción.
      */
-    map<id_billetera, Billetera *> _billeteras;
+    map<id_billetera, Billetera *, less<id_billetera>, AsignadorContado<pair<const id_billetera, Billetera*>>> _billeteras;
+
+    /**
+     * Las mismas billeteras que `_billeteras`, en un vector ordenado por id.
+     * Lo usan las consultas por lote, que buscan varios ids a la vez y
+     * necesitan saber de antemano qué posiciones van a leer para pedirlas a
+     * la caché. Como los ids se asignan en orden creciente, registrar una
+     * billetera es agregar al final.
+     */
+    vector<pair<id_billetera, Billetera*>, AsignadorContado<pair<id_billetera, Billetera*>>> _indice_billeteras;
+
+    /** Registro persistente donde se escriben las transacciones, o nullptr. */
+    RegistroPersistente* _registro;
+
+    /**
+     * Ticket de la última transacción impactada: el de `_registro`, o sin
+     * registro persistente la cantidad de transacciones impactadas.
+     */
+    unsigned long long _ultimo_ticket;
+
+    /** Réplica en memoria compartida donde se publican los saldos, o nullptr. */
+    ReplicaSaldos* _replica;
+
+    /** Si las billeteras nuevas arman sus índices recién al consultarlas. */
+    bool _indices_perezosos;
 
     /** Lleva cuenta del siguiente id a utilizar. */
     id_billetera _siguiente_id_billetera;
 
     /** El saldo inicial de todas las billeteras al momento de registrarse. */
     static const monto SALDO_INICIAL = 100;
+
+    /**
+     * En las consultas por lote, cuántas billeteras adelante de la que se
+     * está procesando se pide cada etapa a la caché.
+     */
+    static const size_t DISTANCIA_ANTICIPACION = 8;
+
+    /** Métodos auxiliares */
+
+    /**
+     * Crea la billetera con el id dado, la registra e impacta su transacción
+     * semilla con el timestamp `momento`.
+     *
+     * Complejidad: O(log(B) + NT)
+     */
+    Billetera* _registrar_billetera(id_billetera id, timestamp momento);
+
+    /**
+     * Agrega una transacción ya validada al listado y notifica a las
+     * billeteras registradas en esta blockchain que participan en ella.
+     *
+     * Complejidad: O(log(B) + NT)
+     */
+    void _impactar_transaccion(Transaccion transaccion);
+
+    /**
+     * Si hay una réplica, publica el estado de `billetera` luego de impactar
+     * `transaccion`.
+     *
+     * Complejidad: O(1) esperado.
+     */
+    void _publicar_saldo(const Billetera* billetera, Transaccion transaccion);
+
+    /**
+     * Busca la billetera de cada id, o nullptr si no está registrada. Devuelve
+     * `true` si y sólo si estaban todas registradas.
+     *
+     * Hace las k búsquedas binarias sobre `_indice_billeteras` a la par, un
+     * nivel por vez, pidiendo a la caché la próxima posición de cada una:
+     * así los fallos de caché de distintas búsquedas se solapan.
+     *
+     * Complejidad: O(k * log(B))
+     */
+    bool _resolver(const vector<id_billetera>& ids, vector<const Billetera*>& billeteras) const;
 };
 
 #endif
@@ -0,0 +1,332 @@
+#include <algorithm>
+#include <queue>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+#include "calendario.h"
+#include "billetera.h"
+#include "blockchain_fragmentada.h"
+#include "registro_persistente.h"
+
+using namespace std;
+
+BlockchainFragmentada::BlockchainFragmentada(unsigned cantidad_fragmentos)
+  : _registro(nullptr)
+  , _siguiente_secuencia(0) {
+  if (cantidad_fragmentos == 0) {
+    cantidad_fragmentos = 1;
+  }
+
+  // sumo 1 porque el id 0 está reservado para las transacciones de saldo
+  // inicial.
+  _primer_id_billetera = static_cast<unsigned int>(rand()) + 1;
+  _ids_confirmados = _primer_id_billetera;
+
+  for (unsigned i = 0; i < cantidad_fragmentos; i++) {
+    _fragmentos.push_back(make_unique<Fragmento>());
+  }
+
+  // Los hilos se lanzan una vez creados todos los fragmentos, ya que un
+  // fragmento puede encolar créditos en cualquier otro.
+  unsigned nucleos = thread::hardware_concurrency();
+  for (unsigned i = 0; i < cantidad_fragmentos; i++) {
+    Fragmento* fragmento = _fragmentos[i].get();
+    fragmento->hilo = thread(&BlockchainFragmentada::_atender, this, fragmento);
+
+#ifdef __linux__
+    // Fijamos cada fragmento a un núcleo para que su estado quede en la
+    // caché de ese núcleo.
+    if (nucleos > 0) {
+      cpu_set_t nucleo;
+      CPU_ZERO(&nucleo);
+      CPU_SET(i % nucleos, &nucleo);
+      pthread_setaffinity_np(fragmento->hilo.native_handle(), sizeof(cpu_set_t), &nucleo);
+    }
+#endif
+  }
+}
+
+Billetera* BlockchainFragmentada::abrir_billetera() {
+  // Se serializa la apertura para que un id sea visible como destino válido
+  // recién cuando la billetera ya está registrada en su fragmento.
+  lock_guard<mutex> lock(_mutex_apertura);
+
+  if (_registro != nullptr && _registro->fallo_escritura()) {
+    return nullptr;
+  }
+
+  id_billetera id = _ids_confirmados.load();
+  timestamp momento = Calendario::tiempo_actual();
+
+  promise<Billetera*> resultado;
+  future<Billetera*> billetera = resultado.get_future();
+  unsigned long long ticket = 0;
+
+  Fragmento* fragmento = _fragmentos[fragmento_de(id)].get();
+  _encolar(fragmento_de(id), [this, fragmento, id, momento, &resultado, &ticket]() {
+    Billetera* nueva = fragmento->blockchain._registrar_billetera(id, momento);
+    fragmento->secuencias.push_back(_siguiente_secuencia++);
+    if (_registro != nullptr) {
+      ticket = _registro->agregar(fragmento->blockchain._transacciones.back());
+    }
+    resultado.set_value(nueva);
+  });
+
+  Billetera* ret = billetera.get();
+  bool durable = _registro == nullptr || _registro->esperar(ticket);
+
+  // Aunque la semilla no sea durable, la billetera quedó registrada en su
+  // fragmento: su id no se vuelve a asignar.
+  _ids_confirmados.store(id + 1);
+
+  return durable ? ret : nullptr;
+}
+
+future<bool> BlockchainFragmentada::enviar_transaccion(Billetera* origen, id_billetera destino, double monto) {
+  // El tiempo se toma en el hilo que encola, no en el del fragmento.
+  timestamp momento = Calendario::tiempo_actual();
+
+  shared_ptr<promise<bool>> resultado = make_shared<promise<bool>>();
+  future<bool> ret = resultado->get_future();
+
+  _encolar(fragmento_de(origen->id()), [this, origen, destino, monto, momento, resultado]() {
+    _debitar(origen, destino, monto, momento, resultado);
+  });
+
+  return ret;
+}
+
+bool BlockchainFragmentada::agregar_transaccion(Billetera* origen, id_billetera destino, double monto) {
+  return enviar_transaccion(origen, destino, monto).get();
+}
+
+void BlockchainFragmentada::sincronizar() {
+  // Se espera a que cada fragmento se vacíe, de a uno. Uno ya vacío puede
+  // recibir después un crédito de otro que seguía trabajando, así que se
+  // repite hasta que una pasada entera no vea tareas encoladas nuevas. Los
+  // créditos no encolan otras tareas: en la práctica alcanza con dos pasadas.
+  unsigned long long encoladas_antes = 0;
+  bool primera = true;
+  while (true) {
+    unsigned long long encoladas = 0;
+    for (auto it = _fragmentos.begin(); it != _fragmentos.end(); ++it) {
+      Fragmento* fragmento = it->get();
+      unique_lock<mutex> lock(fragmento->mutex_cola);
+      fragmento->sin_pendientes.wait(lock, [fragmento]() { return fragmento->pendientes == 0; });
+      encoladas += fragmento->encoladas;
+    }
+
+    if (!primera && encoladas == encoladas_antes) {
+      return;
+    }
+    encoladas_antes = encoladas;
+    primera = false;
+  }
+}
+
+void BlockchainFragmentada::persistir_en(RegistroPersistente* registro) {
+  _registro = registro;
+}
+
+void BlockchainFragmentada::publicar_saldos_en(ReplicaSaldos* replica) {
+  // Cada billetera es publicada sólo por el hilo de su fragmento.
+  for (auto it = _fragmentos.begin(); it != _fragmentos.end(); ++it) {
+    (*it)->blockchain.publicar_saldos_en(replica);
+  }
+}
+
+void BlockchainFragmentada::fijar_indices_perezosos(bool perezosos) {
+  for (auto it = _fragmentos.begin(); it != _fragmentos.end(); ++it) {
+    (*it)->blockchain.fijar_indices_perezosos(perezosos);
+  }
+}
+
+list<Transaccion> BlockchainFragmentada::transacciones() {
+  sincronizar();
+
+  // Cada fragmento aporta sólo las transacciones que se confirmaron en él
+  // (las que tienen origen local, o las semillas de sus billeteras). Como las
+  // secuencias se asignan en el hilo del fragmento, quedan ordenadas y
+  // alcanza con hacer un merge de N listas.
+  vector<vector<pair<unsigned long long, Transaccion>>> propias(_fragmentos.size());
+  for (unsigned i = 0; i < _fragmentos.size(); i++) {
+    const ListaTransacciones& registro = _fragmentos[i]->blockchain.transacciones();
+    auto secuencia_it = _fragmentos[i]->secuencias.begin();
+    for (auto it = registro.begin(); it != registro.end(); ++it, ++secuencia_it) {
+      id_billetera confirmada_por = it->origen == 0 ? it->destino : it->origen;
+      if (fragmento_de(confirmada_por) == i) {
+        propias[i].push_back({*secuencia_it, *it});
+      }
+    }
+  }
+
+  typedef pair<unsigned long long, unsigned> Cabeza; // (secuencia, fragmento)
+  priority_queue<Cabeza, vector<Cabeza>, greater<Cabeza>> cabezas;
+  vector<size_t> posiciones(_fragmentos.size(), 0);
+  for (unsigned i = 0; i < propias.size(); i++) {
+    if (!propias[i].empty()) {
+      cabezas.push({propias[i][0].first, i});
+    }
+  }
+
+  list<Transaccion> ret;
+  while (!cabezas.empty()) {
+    unsigned i = cabezas.top().second;
+    cabezas.pop();
+
+    ret.push_back(propias[i][posiciones[i]].second);
+    posiciones[i]++;
+    if (posiciones[i] < propias[i].size()) {
+      cabezas.push({propias[i][posiciones[i]].first, i});
+    }
+  }
+
+  return ret;
+}
+
+BlockchainFragmentada::ReporteMemoria BlockchainFragmentada::memoria(size_t cantidad_mas_pesadas) {
+  sincronizar();
+
+  // Las más pesadas de todos los fragmentos están entre las más pesadas de
+  // cada uno.
+  ReporteMemoria reporte;
+  vector<pair<id_billetera, MemoriaBilletera>>& mas_pesadas = reporte.fragmentos.mas_pesadas;
+  for (auto it = _fragmentos.begin(); it != _fragmentos.end(); ++it) {
+    Blockchain::ReporteMemoria propio = (*it)->blockchain.memoria(cantidad_mas_pesadas);
+    reporte.fragmentos.transacciones += propio.transacciones;
+    reporte.fragmentos.registro_billeteras += propio.registro_billeteras;
+    reporte.fragmentos.billeteras += propio.billeteras;
+    mas_pesadas.insert(mas_pesadas.end(), propio.mas_pesadas.begin(), propio.mas_pesadas.end());
+    reporte.secuencias += (*it)->bytes_secuencias;
+  }
+
+  stable_sort(mas_pesadas.begin(), mas_pesadas.end(),
+              [](const pair<id_billetera, MemoriaBilletera>& a, const pair<id_billetera, MemoriaBilletera>& b) {
+                return a.second.total() > b.second.total();
+              });
+  if (mas_pesadas.size() > cantidad_mas_pesadas) {
+    mas_pesadas.resize(cantidad_mas_pesadas);
+  }
+
+  return reporte;
+}
+
+unsigned BlockchainFragmentada::cantidad_fragmentos() const {
+  return _fragmentos.size();
+}
+
+unsigned BlockchainFragmentada::fragmento_de(id_billetera id) const {
+  return id % _fragmentos.size();
+}
+
+BlockchainFragmentada::~BlockchainFragmentada() {
+  sincronizar();
+
+  for (auto it = _fragmentos.begin(); it != _fragmentos.end(); ++it) {
+    {
+      lock_guard<mutex> lock((*it)->mutex_cola);
+      (*it)->detener = true;
+    }
+    (*it)->hay_tareas.notify_one();
+  }
+
+  for (auto it = _fragmentos.begin(); it != _fragmentos.end(); ++it) {
+    (*it)->hilo.join();
+  }
+}
+
+
+/** Métodos privados auxiliares */
+
+void BlockchainFragmentada::_encolar(unsigned fragmento, function<void()> tarea) {
+  Fragmento* destino = _fragmentos[fragmento].get();
+  {
+    lock_guard<mutex> lock(destino->mutex_cola);
+    destino->cola.push_back(move(tarea));
+    destino->pendientes++;
+    destino->encoladas++;
+  }
+  destino->hay_tareas.notify_one();
+}
+
+void BlockchainFragmentada::_atender(Fragmento* fragmento) {
+  bool termine_una = false;
+  while (true) {
+    function<void()> tarea;
+    {
+      unique_lock<mutex> lock(fragmento->mutex_cola);
+      // La tarea anterior se descuenta al tomar la siguiente, así el hilo
+      // toma el lock de su cola una sola vez por tarea. Si encoló un crédito
+      // en otro fragmento, ese fragmento ya lo cuenta como pendiente.
+      if (termine_una && --fragmento->pendientes == 0) {
+        fragmento->sin_pendientes.notify_all();
+      }
+      fragmento->hay_tareas.wait(lock, [fragmento]() { return fragmento->detener || !fragmento->cola.empty(); });
+      if (fragmento->cola.empty()) {
+        return; // detener y sin tareas pendientes
+      }
+      tarea = move(fragmento->cola.front());
+      fragmento->cola.pop_front();
+    }
+
+    tarea();
+    termine_una = true;
+  }
+}
+
+void BlockchainFragmentada::_impactar(Fragmento* fragmento, Transaccion transaccion, unsigned long long secuencia) {
+  fragmento->blockchain._impactar_transaccion(transaccion);
+  fragmento->secuencias.push_back(secuencia);
+}
+
+void BlockchainFragmentada::_debitar(Billetera* origen, id_billetera destino, double monto, timestamp momento, shared_ptr<promise<bool>> resultado) {
+  Fragmento* fragmento_origen = _fragmentos[fragmento_de(origen->id())].get();
+  const auto& registro = fragmento_origen->blockchain._billeteras;
+  auto origen_it = registro.find(origen->id());
+
+  bool billeteras_distintas = origen->id() != destino;
+  bool origen_valido = origen_it != registro.end() && origen_it->second == origen;
+  // Los ids se asignan de forma consecutiva, así que alcanza con mirar el
+  // rango sin consultar al fragmento destino.
+  bool destino_valido = destino - _primer_id_billetera < _ids_confirmados.load() - _primer_id_billetera;
+  // El listado del fragmento contiene todas las transacciones de la billetera
+  // origen, así que su saldo coincide con `calcular_saldo`.
+  bool saldo_suficiente = origen_valido && origen->saldo() >= monto;
+  // Con el registro ya fallado la transacción nunca sería durable: se
+  // rechaza antes de debitarla.
+  bool registro_sano = _registro == nullptr || !_registro->fallo_escritura();
+
+  bool transaccion_aprobada = billeteras_distintas && origen_valido && destino_valido && saldo_suficiente && registro_sano;
+
+  if (!transaccion_aprobada) {
+    resultado->set_value(false);
+    return;
+  }
+
+  Transaccion transaccion = {origen->id(), destino, monto, momento};
+  unsigned long long secuencia = _siguiente_secuencia++;
+
+  // Fase 1: débito en el fragmento origen (si el destino es local, también
+  // se acredita acá).
+  _impactar(fragmento_origen, transaccion, secuencia);
+
+  // Fase 2: crédito en el fragmento destino.
+  unsigned fragmento_destino = fragmento_de(destino);
+  if (_fragmentos[fragmento_destino].get() != fragmento_origen) {
+    Fragmento* destino_fragmento = _fragmentos[fragmento_destino].get();
+    _encolar(fragmento_destino, [this, destino_fragmento, transaccion, secuencia]() {
+      _impactar(destino_fragmento, transaccion, secuencia);
+    });
+  }
+
+  // Sólo el fragmento origen escribe la transacción en el registro. El
+  // resultado se informa desde el hilo escritor cuando su grupo es durable.
+  if (_registro != nullptr) {
+    _registro->agregar(transaccion, [resultado](bool confirmada) { resultado->set_value(confirmada); });
+    return;
+  }
+
+  resultado->set_value(true);
+}
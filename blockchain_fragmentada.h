@@ -0,0 +1,234 @@
+#ifndef BLOCKCHAIN_FRAGMENTADA_H
+#define BLOCKCHAIN_FRAGMENTADA_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "lib.h"
+#include "blockchain.h"
+
+using namespace std;
+
+class Billetera;
+class RegistroPersistente;
+class ReplicaSaldos;
+
+/**
+ * Blockchain particionada en N fragmentos. Cada billetera vive en el
+ * fragmento `id % N`, y cada fragmento tiene su propio hilo, su propio
+ * listado de transacciones, su propio registro y sus propias billeteras (se
+ * implementa con una `Blockchain` por fragmento).
+ *
+ * Todo el estado de un fragmento es manipulado exclusivamente por su hilo:
+ * las operaciones públicas encolan tareas en la cola del fragmento que
+ * corresponda.
+ *
+ * Transferencias:
+ *   - Dentro del mismo fragmento se validan e impactan localmente.
+ *   - Entre fragmentos distintos se hacen en dos fases: el fragmento origen
+ *     valida y debita (impacta la transacción en su registro y notifica a la
+ *     billetera origen), y luego encola el crédito en la cola del fragmento
+ *     destino. Como el saldo de una billetera sólo se reduce desde su propio
+ *     fragmento, el origen nunca queda en negativo.
+ *
+ * Cada transacción recibe un número de secuencia global al confirmarse en su
+ * fragmento origen, que se usa para armar la vista unificada de
+ * `transacciones()`.
+ *
+ * Con un registro persistente, todos los fragmentos escriben en el mismo
+ * registro, por lo que las transacciones que llegan a la vez se confirman en
+ * disco en un mismo grupo.
+ *
+ * INVARIANTE DE REPRESENTACIÓN:
+ *  - Para todo id en [_primer_id_billetera, _ids_confirmados), la billetera
+ *    está registrada en `_fragmentos[fragmento_de(id)]`.
+ *  - Para cada fragmento, `secuencias` tiene la misma longitud que el listado
+ *    de transacciones de su blockchain, y la posición i es la secuencia de la
+ *    i-ésima transacción.
+ */
+class BlockchainFragmentada {
+  public:
+    /** Memoria de la blockchain fragmentada, en bytes. */
+    struct ReporteMemoria {
+      /**
+       * Suma de los reportes de las blockchains de los fragmentos. Las más
+       * pesadas son las de todos los fragmentos. Los créditos entre
+       * fragmentos están en el listado de ambos fragmentos, así que cuentan
+       * dos veces.
+       */
+      Blockchain::ReporteMemoria fragmentos;
+
+      /** Secuencias globales de las transacciones de cada fragmento. */
+      size_t secuencias = 0;
+
+      size_t total() const {
+        return fragmentos.total() + secuencias;
+      }
+    };
+
+    /**
+     * Constructor. Lanza un hilo por fragmento. Si `cantidad_fragmentos` es 0
+     * se usa un único fragmento.
+     */
+    explicit BlockchainFragmentada(unsigned cantidad_fragmentos = thread::hardware_concurrency());
+
+    /**
+     * Registra una billetera en su fragmento y devuelve un puntero a la
+     * misma. Todas las billeteras tienen un saldo inicial de 100 unidades.
+     *
+     * La billetera es modificada por el hilo de su fragmento: sólo es seguro
+     * consultarla luego de `sincronizar()`.
+     *
+     * Si hay un registro persistente, vuelve recién cuando la transacción
+     * semilla es durable. Devuelve nullptr si el registro falló: sin abrir la
+     * billetera si ya había fallado antes, o con la billetera abierta en su
+     * fragmento pero sin semilla durable si falló la escritura de su grupo.
+     */
+    Billetera* abrir_billetera();
+
+    /**
+     * Encola una transacción en el fragmento de la billetera origen y
+     * devuelve un `future` que se resuelve con `true` si y sólo si la
+     * transacción fue aprobada (mismas validaciones que
+     * `Blockchain::agregar_transaccion`).
+     *
+     * Si el destino vive en otro fragmento, el `future` se resuelve al
+     * debitar el origen; el crédito se impacta luego en el fragmento destino.
+     *
+     * Si hay un registro persistente, el `future` se resuelve recién cuando la
+     * transacción es durable (o con `false` si falló la escritura). El hilo
+     * del fragmento no se bloquea esperando al disco.
+     */
+    future<bool> enviar_transaccion(Billetera* origen, id_billetera destino, double monto);
+
+    /**
+     * Igual a `enviar_transaccion`, pero espera al resultado.
+     */
+    bool agregar_transaccion(Billetera* origen, id_billetera destino, double monto);
+
+    /**
+     * Espera a que todos los fragmentos terminen de procesar las tareas
+     * encoladas, incluidos los créditos entre fragmentos.
+     */
+    void sincronizar();
+
+    /**
+     * Vista unificada de todas las transacciones, ordenadas por secuencia
+     * global. Sincroniza antes de armarla, por lo que no debe llamarse
+     * mientras otros hilos siguen encolando transacciones.
+     *
+     * Complejidad: O(T * log(N)), donde N es la cantidad de fragmentos.
+     */
+    list<Transaccion> transacciones();
+
+    /**
+     * Reporte de la memoria de todos los fragmentos, con el detalle de las
+     * `cantidad_mas_pesadas` billeteras que más ocupan entre todos ellos.
+     * Sincroniza antes de armarlo, por lo que no debe llamarse mientras otros
+     * hilos siguen encolando transacciones.
+     *
+     * Complejidad: O(B * log(N)), donde N es `cantidad_mas_pesadas`
+     */
+    ReporteMemoria memoria(size_t cantidad_mas_pesadas = 10);
+
+    /**
+     * Hace que todas las transacciones que se confirmen de acá en más se
+     * escriban en `registro`. Debe llamarse antes de encolar operaciones. No
+     * toma posesión del registro.
+     */
+    void persistir_en(RegistroPersistente* registro);
+
+    /**
+     * Hace que cada fragmento publique en `replica` el estado de sus
+     * billeteras con cada transacción que impacte. Debe llamarse antes de
+     * encolar operaciones. No toma posesión de la réplica.
+     */
+    void publicar_saldos_en(ReplicaSaldos* replica);
+
+    /**
+     * Fija el modo de índices perezosos de las blockchains de todos los
+     * fragmentos (ver `Blockchain::fijar_indices_perezosos`). Debe llamarse
+     * antes de encolar operaciones.
+     */
+    void fijar_indices_perezosos(bool perezosos);
+
+    /** Cantidad de fragmentos. */
+    unsigned cantidad_fragmentos() const;
+
+    /** Fragmento al que pertenece la billetera `id`. */
+    unsigned fragmento_de(id_billetera id) const;
+
+    /**
+     * Destructor. Sincroniza (así ningún fragmento se detiene antes de
+     * recibir los créditos que le encolan los demás) y detiene los hilos.
+     */
+    ~BlockchainFragmentada();
+
+  private:
+    struct Fragmento {
+      /** Registro, listado y billeteras del fragmento. */
+      Blockchain blockchain;
+
+      /** Bytes pedidos por `secuencias`. */
+      size_t bytes_secuencias = 0;
+
+      /** Secuencia global de cada transacción de `blockchain`. */
+      list<unsigned long long, AsignadorContado<unsigned long long>> secuencias{
+        AsignadorContado<unsigned long long>(&bytes_secuencias)};
+
+      /** Cola de tareas, protegida por `mutex_cola`. */
+      deque<function<void()>> cola;
+      mutex mutex_cola;
+      condition_variable hay_tareas;
+      bool detener = false;
+
+      /**
+       * Tareas encoladas en este fragmento y no terminadas (incluida la que
+       * se está ejecutando). Protegido por `mutex_cola`.
+       */
+      size_t pendientes = 0;
+      condition_variable sin_pendientes;
+
+      /** Tareas encoladas desde que se creó. Protegido por `mutex_cola`. */
+      unsigned long long encoladas = 0;
+
+      thread hilo;
+    };
+
+    vector<unique_ptr<Fragmento>> _fragmentos;
+
+    /** Primer id asignado. Los ids se asignan de forma consecutiva. */
+    id_billetera _primer_id_billetera;
+
+    /** Ids menores a este valor ya están registrados en su fragmento. */
+    atomic<id_billetera> _ids_confirmados;
+
+    /** Serializa la apertura de billeteras. */
+    mutex _mutex_apertura;
+
+    /** Registro persistente compartido por los fragmentos, o nullptr. */
+    RegistroPersistente* _registro;
+
+    /** Siguiente número de secuencia global. */
+    atomic<unsigned long long> _siguiente_secuencia;
+
+    /** Métodos auxiliares */
+
+    void _encolar(unsigned fragmento, function<void()> tarea);
+
+    void _atender(Fragmento* fragmento);
+
+    void _impactar(Fragmento* fragmento, Transaccion transaccion, unsigned long long secuencia);
+
+    void _debitar(Billetera* origen, id_billetera destino, double monto, timestamp momento, shared_ptr<promise<bool>> resultado);
+};
+
+#endif
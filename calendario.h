@@ -55,6 +55,18 @@ class Calendario {
       return t + DURACION_DIA;
     }
 
+    /*
+    * Retorna la cantidad de días entre el día de `desde` y el día de `hasta`.
+    * Si ambos caen en el mismo día retorna 0.
+    *
+    * Se asume como precondición que `desde` es menor o igual a `hasta`.
+    *
+    * Complejidad: O(1)
+    */
+    static unsigned int dias_entre(timestamp desde, timestamp hasta) {
+      return (principio_del_dia(hasta) - principio_del_dia(desde)) / DURACION_DIA;
+    }
+
     //--------------------------------------------------------------------------
     // Las funciones de aquí en más se utilizan para proveer una forma sencilla
     // de controlar el tiempo actual en los tests.
@@ -0,0 +1,149 @@
+#include <algorithm>
+
+#include "calendario.h"
+#include "frecuencias_ventana.h"
+
+using namespace std;
+
+FrecuenciasVentana::FrecuenciasVentana(unsigned dias, size_t* bytes)
+  : _largo(dias)
+  , _dia_mas_reciente(0)
+  , _dias(AsignadorContado<Dia>(bytes))
+  , _grupos(AsignadorContado<Grupo>(bytes))
+  , _posiciones(AsignadorContado<pair<const id_billetera, Posicion>>(bytes)) {
+}
+
+unsigned FrecuenciasVentana::dias() const {
+  return _largo;
+}
+
+void FrecuenciasVentana::registrar(id_billetera destinatario, timestamp t) {
+  avanzar(t); // O(1) amortizado
+
+  timestamp dia = Calendario::principio_del_dia(t); // O(1)
+  if (_vencido(dia)) { // O(1)
+    return; // O(1)
+  }
+
+  if (_dias.empty() || _dias.back().principio < dia) { // O(1)
+    _dias.push_back(_nuevo_dia(dia)); // O(1) amortizado
+  }
+
+  auto balde = _dias.end() - 1; // O(1)
+  if (balde->principio != dia) {
+    // Envío de un día anterior al más reciente: buscamos (o creamos) su
+    // balde. Hay a lo sumo W baldes.
+    balde = lower_bound(_dias.begin(), _dias.end(), dia, [](const Dia& d, timestamp principio) {
+      return d.principio < principio;
+    }); // O(log W)
+    if (balde->principio != dia) {
+      balde = _dias.insert(balde, _nuevo_dia(dia)); // O(W)
+    }
+  }
+
+  balde->destinatarios.push_back(destinatario); // O(1) amortizado
+  _incrementar(destinatario); // O(1)
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(1) amortizado, O(W) si el envío es de un día anterior al más reciente.
+}
+
+void FrecuenciasVentana::avanzar(timestamp ahora) {
+  timestamp dia = Calendario::principio_del_dia(ahora); // O(1)
+  if (dia <= _dia_mas_reciente) { // O(1)
+    return; // O(1)
+  }
+  _dia_mas_reciente = dia; // O(1)
+
+  // Cada envío se descuenta una única vez, cuando vence su balde, así que el
+  // costo total del ciclo se amortiza contra los `registrar`.
+  while (!_dias.empty() && _vencido(_dias.front().principio)) {
+    const auto& vencidos = _dias.front().destinatarios;
+    for (auto it = vencidos.begin(); it != vencidos.end(); ++it) {
+      _decrementar(*it); // O(1)
+    }
+    _dias.pop_front(); // O(1)
+  }
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(1) amortizado.
+}
+
+vector<id_billetera> FrecuenciasVentana::mas_frecuentes(int k) const {
+  vector<id_billetera> ret; // O(1)
+  size_t cantidad = k > 0 ? k : 0; // O(1)
+
+  // Recorremos los grupos de mayor a menor cantidad; cada iteración del
+  // ciclo interno agrega un destinatario, así que en total son O(k) pasos.
+  for (auto grupo = _grupos.rbegin(); grupo != _grupos.rend() && ret.size() < cantidad; ++grupo) {
+    for (auto it = grupo->destinatarios.begin(); it != grupo->destinatarios.end() && ret.size() < cantidad; ++it) {
+      ret.push_back(*it); // O(1)
+    }
+  }
+
+  return ret; // O(1)
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(k)
+}
+
+
+/** Métodos privados auxiliares */
+
+bool FrecuenciasVentana::_vencido(timestamp principio_del_dia) const {
+  return principio_del_dia < _dia_mas_reciente && Calendario::dias_entre(principio_del_dia, _dia_mas_reciente) >= _largo;
+}
+
+FrecuenciasVentana::Dia FrecuenciasVentana::_nuevo_dia(timestamp principio) const {
+  return {principio, vector<id_billetera, AsignadorContado<id_billetera>>(_dias.get_allocator())};
+}
+
+FrecuenciasVentana::Grupo FrecuenciasVentana::_nuevo_grupo(unsigned cantidad) const {
+  return {cantidad, ListaDestinatarios(_grupos.get_allocator())};
+}
+
+void FrecuenciasVentana::_incrementar(id_billetera destinatario) {
+  auto posicion = _posiciones.find(destinatario); // O(1) esperado
+
+  if (posicion == _posiciones.end()) {
+    if (_grupos.empty() || _grupos.front().cantidad != 1) {
+      _grupos.push_front(_nuevo_grupo(1)); // O(1)
+    }
+    auto grupo = _grupos.begin(); // O(1)
+    grupo->destinatarios.push_front(destinatario); // O(1)
+    _posiciones[destinatario] = {grupo, grupo->destinatarios.begin()}; // O(1) esperado
+    return;
+  }
+
+  auto grupo = posicion->second.grupo; // O(1)
+  auto siguiente = next(grupo); // O(1)
+  if (siguiente == _grupos.end() || siguiente->cantidad != grupo->cantidad + 1) {
+    siguiente = _grupos.insert(siguiente, _nuevo_grupo(grupo->cantidad + 1)); // O(1)
+  }
+
+  // `splice` no invalida el iterador al destinatario.
+  siguiente->destinatarios.splice(siguiente->destinatarios.begin(), grupo->destinatarios, posicion->second.destinatario); // O(1)
+  posicion->second.grupo = siguiente; // O(1)
+
+  if (grupo->destinatarios.empty()) {
+    _grupos.erase(grupo); // O(1)
+  }
+}
+
+void FrecuenciasVentana::_decrementar(id_billetera destinatario) {
+  auto posicion = _posiciones.find(destinatario); // O(1) esperado
+  auto grupo = posicion->second.grupo; // O(1)
+
+  if (grupo->cantidad == 1) {
+    grupo->destinatarios.erase(posicion->second.destinatario); // O(1)
+    _posiciones.erase(posicion); // O(1)
+  } else {
+    auto anterior = grupo; // O(1)
+    if (grupo == _grupos.begin() || (--anterior)->cantidad != grupo->cantidad - 1) {
+      anterior = _grupos.insert(grupo, _nuevo_grupo(grupo->cantidad - 1)); // O(1)
+    }
+    anterior->destinatarios.splice(anterior->destinatarios.begin(), grupo->destinatarios, posicion->second.destinatario); // O(1)
+    posicion->second.grupo = anterior; // O(1)
+  }
+
+  if (grupo->destinatarios.empty()) {
+    _grupos.erase(grupo); // O(1)
+  }
+}
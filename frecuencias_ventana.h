@@ -0,0 +1,138 @@
+#ifndef FRECUENCIAS_VENTANA_H
+#define FRECUENCIAS_VENTANA_H
+
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "lib.h"
+#include "memoria.h"
+
+using namespace std;
+
+/**
+ * Cuenta cuántas veces se envió dinero a cada destinatario durante los
+ * últimos `dias` días, y permite listar los más frecuentes.
+ *
+ * Los envíos se agrupan en baldes por día (según `Calendario`). Cuando el día
+ * más reciente avanza, los baldes que quedan fuera de la ventana se vencen y
+ * sus envíos se descuentan de a uno, así que cada envío se cuenta y se
+ * descuenta una sola vez.
+ *
+ * Los contadores se guardan en una lista de grupos ordenada por cantidad
+ * (cada grupo tiene los destinatarios con esa cantidad de envíos), de modo
+ * que sumar o restar un envío mueve al destinatario al grupo vecino en O(1).
+ *
+ * INVARIANTE DE REPRESENTACIÓN:
+ *  - `_dias` está ordenado de forma estrictamente creciente por día, y todos
+ *    sus días están dentro de la ventana que termina en `_dia_mas_reciente`.
+ *  - Para cada destinatario, su cantidad es la cantidad de apariciones en los
+ *    baldes de `_dias`.
+ *  - `_grupos` está ordenado de forma estrictamente creciente por cantidad,
+ *    no tiene grupos vacíos ni cantidades 0, y cada destinatario con cantidad
+ *    positiva aparece en exactamente un grupo.
+ *  - `_posiciones` tiene una entrada por destinatario con cantidad positiva,
+ *    que apunta a su grupo y a su posición dentro del grupo.
+ */
+class FrecuenciasVentana {
+  public:
+    /**
+     * Constructor. `dias` es el largo de la ventana, incluyendo el día
+     * actual. Si se pasa `bytes`, ahí se lleva la cuenta de la memoria que
+     * ocupan las estructuras.
+     */
+    explicit FrecuenciasVentana(unsigned dias, size_t* bytes = nullptr);
+
+    /**
+     * `_posiciones` guarda iteradores a `_grupos`: una copia apuntaría a los
+     * grupos del original, así que no se copia. Mover conserva los nodos (y
+     * los iteradores); la asignación por movimiento sólo los conserva si
+     * ambas ventanas cuentan su memoria en el mismo lugar, como cuando una
+     * billetera rearma su ventana.
+     */
+    FrecuenciasVentana(const FrecuenciasVentana&) = delete;
+    FrecuenciasVentana& operator=(const FrecuenciasVentana&) = delete;
+    FrecuenciasVentana(FrecuenciasVentana&&) = default;
+    FrecuenciasVentana& operator=(FrecuenciasVentana&&) = default;
+
+    /** Largo de la ventana en días. */
+    unsigned dias() const;
+
+    /**
+     * Registra un envío a `destinatario` en el momento `t`. Si `t` es
+     * posterior al día más reciente, la ventana avanza. Si `t` ya quedó fuera
+     * de la ventana, se ignora.
+     *
+     * Complejidad: O(1) amortizado (O(W) si `t` es de un día anterior al más
+     * reciente, donde W es el largo de la ventana).
+     */
+    void registrar(id_billetera destinatario, timestamp t);
+
+    /**
+     * Avanza la ventana para que termine en el día de `ahora` (si es
+     * posterior al día más reciente), descontando los envíos vencidos.
+     *
+     * Complejidad: O(1) amortizado.
+     */
+    void avanzar(timestamp ahora);
+
+    /**
+     * Devuelve los `k` destinatarios con más envíos dentro de la ventana, de
+     * mayor a menor cantidad.
+     *
+     * Complejidad: O(k)
+     */
+    vector<id_billetera> mas_frecuentes(int k) const;
+
+  private:
+    typedef list<id_billetera, AsignadorContado<id_billetera>> ListaDestinatarios;
+
+    struct Grupo {
+      unsigned cantidad;
+      ListaDestinatarios destinatarios;
+    };
+
+    typedef list<Grupo, AsignadorContado<Grupo>> ListaGrupos;
+
+    struct Posicion {
+      ListaGrupos::iterator grupo;
+      ListaDestinatarios::iterator destinatario;
+    };
+
+    struct Dia {
+      timestamp principio;
+      vector<id_billetera, AsignadorContado<id_billetera>> destinatarios;
+    };
+
+    /** Largo de la ventana en días. */
+    unsigned _largo;
+
+    /** Principio del día más reciente visto. */
+    timestamp _dia_mas_reciente;
+
+    /** Baldes de envíos por día. */
+    deque<Dia, AsignadorContado<Dia>> _dias;
+
+    ListaGrupos _grupos;
+
+    unordered_map<id_billetera, Posicion, hash<id_billetera>, equal_to<id_billetera>, AsignadorContado<pair<const id_billetera, Posicion>>> _posiciones;
+
+    /** Métodos auxiliares */
+
+    bool _vencido(timestamp principio_del_dia) const;
+
+    /**
+     * Día y grupo vacíos, con el asignador de la ventana: los destinatarios
+     * se mueven entre grupos con `splice`, que requiere asignadores iguales.
+     */
+    Dia _nuevo_dia(timestamp principio) const;
+
+    Grupo _nuevo_grupo(unsigned cantidad) const;
+
+    void _incrementar(id_billetera destinatario);
+
+    void _decrementar(id_billetera destinatario);
+};
+
+#endif
@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <queue>
+
+#include "paralelo.h"
+#include "grafo_transacciones.h"
+
+using namespace std;
+
+namespace {
+
+/** Transferencia ya traducida a vértices, antes de agrupar repetidas. */
+struct Transferencia {
+  unsigned origen;
+  unsigned destino;
+  double monto;
+};
+
+bool menor_por_vertices(const Transferencia& a, const Transferencia& b) {
+  return a.origen < b.origen || (a.origen == b.origen && a.destino < b.destino);
+}
+
+bool mas_pesado(const GrafoTransacciones::Flujo& a, const GrafoTransacciones::Flujo& b) {
+  return a.monto > b.monto;
+}
+
+}
+
+size_t GrafoTransacciones::cantidad_vertices() const {
+  return _billeteras.size();
+}
+
+size_t GrafoTransacciones::cantidad_aristas() const {
+  return _destinos.size();
+}
+
+id_billetera GrafoTransacciones::billetera(size_t v) const {
+  return _billeteras[v];
+}
+
+size_t GrafoTransacciones::vertice(id_billetera id) const {
+  auto it = lower_bound(_billeteras.begin(), _billeteras.end(), id);
+  if (it == _billeteras.end() || *it != id) {
+    return _billeteras.size();
+  }
+  return it - _billeteras.begin();
+}
+
+size_t GrafoTransacciones::grado_salida(size_t v) const {
+  return _inicio_salientes[v + 1] - _inicio_salientes[v];
+}
+
+size_t GrafoTransacciones::grado_entrada(size_t v) const {
+  return _inicio_entrantes[v + 1] - _inicio_entrantes[v];
+}
+
+vector<int> GrafoTransacciones::bfs(id_billetera origen, unsigned hilos) const {
+  size_t cantidad = cantidad_vertices();
+  vector<atomic<int>> distancias(cantidad);
+  para_cada_bloque(cantidad, hilos, [&distancias](unsigned, size_t desde, size_t hasta) {
+    for (size_t v = desde; v < hasta; v++) {
+      distancias[v].store(-1, memory_order_relaxed);
+    }
+  });
+
+  vector<unsigned> frontera;
+  size_t inicio = vertice(origen);
+  if (inicio < cantidad) {
+    distancias[inicio] = 0;
+    frontera.push_back(inicio);
+  }
+
+  // BFS por niveles: cada hilo expande una parte de la frontera y reclama
+  // los vértices nuevos con compare-and-swap, así cada uno entra una sola vez
+  // a la frontera siguiente.
+  int nivel = 0;
+  while (!frontera.empty()) {
+    vector<vector<unsigned>> siguientes(hilos_a_usar(hilos));
+    para_cada_bloque(frontera.size(), hilos, [this, &frontera, &siguientes, &distancias, nivel](unsigned h, size_t desde, size_t hasta) {
+      for (size_t i = desde; i < hasta; i++) {
+        unsigned u = frontera[i];
+        for (size_t e = _inicio_salientes[u]; e < _inicio_salientes[u + 1]; e++) {
+          unsigned v = _destinos[e];
+          int sin_visitar = -1;
+          if (distancias[v].load(memory_order_relaxed) == -1 && distancias[v].compare_exchange_strong(sin_visitar, nivel + 1)) {
+            siguientes[h].push_back(v);
+          }
+        }
+      }
+    });
+
+    frontera.clear();
+    for (auto it = siguientes.begin(); it != siguientes.end(); ++it) {
+      frontera.insert(frontera.end(), it->begin(), it->end());
+    }
+    nivel++;
+  }
+
+  vector<int> ret(cantidad);
+  for (size_t v = 0; v < cantidad; v++) {
+    ret[v] = distancias[v].load(memory_order_relaxed);
+  }
+  return ret;
+}
+
+vector<size_t> GrafoTransacciones::componentes_conexas(unsigned hilos) const {
+  size_t cantidad = cantidad_vertices();
+  vector<atomic<size_t>> padre(cantidad);
+  para_cada_bloque(cantidad, hilos, [&padre](unsigned, size_t desde, size_t hasta) {
+    for (size_t v = desde; v < hasta; v++) {
+      padre[v].store(v, memory_order_relaxed);
+    }
+  });
+
+  // Búsqueda con división de caminos ("path halving"): cada vértice visitado
+  // pasa a apuntar a su abuelo, así los caminos se acortan a medida que se
+  // recorren. Sólo se reapuntan vértices que no son raíz, y siempre a un
+  // ancestro, por lo que no compite con el enganche de raíces: si otro hilo
+  // ya lo cambió, el compare-and-swap falla y se sigue igual.
+  auto raiz = [&padre](size_t v) {
+    while (true) {
+      size_t p = padre[v].load();
+      if (p == v) {
+        return v;
+      }
+      size_t abuelo = padre[p].load();
+      if (abuelo != p) {
+        padre[v].compare_exchange_weak(p, abuelo);
+      }
+      v = abuelo;
+    }
+  };
+
+  // Para cada arista unimos las componentes de sus extremos, colgando
+  // siempre la raíz mayor de la menor. Si otro hilo cambió la raíz en el
+  // medio, el compare-and-swap falla y reintentamos. Como nunca se cuelga a
+  // la raíz menor, al final cada componente queda con su menor vértice como
+  // raíz.
+  para_cada_bloque(cantidad, hilos, [this, &padre, &raiz](unsigned, size_t desde, size_t hasta) {
+    for (size_t u = desde; u < hasta; u++) {
+      for (size_t e = _inicio_salientes[u]; e < _inicio_salientes[u + 1]; e++) {
+        while (true) {
+          size_t raiz_u = raiz(u);
+          size_t raiz_v = raiz(_destinos[e]);
+          if (raiz_u == raiz_v) {
+            break;
+          }
+
+          size_t mayor = max(raiz_u, raiz_v);
+          if (padre[mayor].compare_exchange_strong(mayor, min(raiz_u, raiz_v))) {
+            break;
+          }
+        }
+      }
+    }
+  });
+
+  vector<size_t> ret(cantidad);
+  para_cada_bloque(cantidad, hilos, [&ret, &raiz](unsigned, size_t desde, size_t hasta) {
+    for (size_t v = desde; v < hasta; v++) {
+      ret[v] = raiz(v);
+    }
+  });
+  return ret;
+}
+
+vector<size_t> GrafoTransacciones::componentes_fuertemente_conexas() const {
+  size_t cantidad = cantidad_vertices();
+  const size_t SIN_VISITAR = cantidad;
+
+  vector<size_t> indice(cantidad, SIN_VISITAR);
+  vector<size_t> minimo(cantidad);
+  vector<bool> en_pila(cantidad, false);
+  vector<size_t> pila;
+  vector<size_t> ret(cantidad);
+  size_t siguiente_indice = 0;
+  size_t siguiente_componente = 0;
+
+  // Tarjan iterativo: en `llamadas` guardamos (vértice, próxima arista a
+  // mirar) en lugar de usar recursión, para no desbordar la pila con grafos
+  // grandes.
+  vector<pair<size_t, size_t>> llamadas;
+  for (size_t raiz = 0; raiz < cantidad; raiz++) {
+    if (indice[raiz] != SIN_VISITAR) {
+      continue;
+    }
+
+    llamadas.push_back({raiz, _inicio_salientes[raiz]});
+    indice[raiz] = minimo[raiz] = siguiente_indice++;
+    pila.push_back(raiz);
+    en_pila[raiz] = true;
+
+    while (!llamadas.empty()) {
+      size_t u = llamadas.back().first;
+      size_t& e = llamadas.back().second;
+
+      if (e < _inicio_salientes[u + 1]) {
+        size_t v = _destinos[e];
+        e++;
+        if (indice[v] == SIN_VISITAR) {
+          indice[v] = minimo[v] = siguiente_indice++;
+          pila.push_back(v);
+          en_pila[v] = true;
+          llamadas.push_back({v, _inicio_salientes[v]});
+        } else if (en_pila[v]) {
+          minimo[u] = min(minimo[u], indice[v]);
+        }
+        continue;
+      }
+
+      // Terminamos con u.
+      llamadas.pop_back();
+      if (!llamadas.empty()) {
+        size_t padre = llamadas.back().first;
+        minimo[padre] = min(minimo[padre], minimo[u]);
+      }
+
+      if (minimo[u] == indice[u]) {
+        size_t w;
+        do {
+          w = pila.back();
+          pila.pop_back();
+          en_pila[w] = false;
+          ret[w] = siguiente_componente;
+        } while (w != u);
+        siguiente_componente++;
+      }
+    }
+  }
+
+  return ret;
+}
+
+vector<double> GrafoTransacciones::ranking(unsigned iteraciones, double amortiguacion, unsigned hilos) const {
+  size_t cantidad = cantidad_vertices();
+  if (cantidad == 0) {
+    return {};
+  }
+
+  vector<double> puntaje(cantidad, 1.0 / cantidad);
+  vector<double> siguiente(cantidad);
+
+  vector<double> peso_salida(cantidad, 0);
+  para_cada_bloque(cantidad, hilos, [this, &peso_salida](unsigned, size_t desde, size_t hasta) {
+    for (size_t u = desde; u < hasta; u++) {
+      for (size_t e = _inicio_salientes[u]; e < _inicio_salientes[u + 1]; e++) {
+        peso_salida[u] += _cantidades[e];
+      }
+    }
+  });
+
+  vector<double> colgantes_por_hilo(hilos_a_usar(hilos));
+  for (unsigned i = 0; i < iteraciones; i++) {
+    fill(colgantes_por_hilo.begin(), colgantes_por_hilo.end(), 0);
+    para_cada_bloque(cantidad, hilos, [&puntaje, &peso_salida, &colgantes_por_hilo](unsigned h, size_t desde, size_t hasta) {
+      for (size_t u = desde; u < hasta; u++) {
+        if (peso_salida[u] == 0) {
+          colgantes_por_hilo[h] += puntaje[u];
+        }
+      }
+    });
+
+    double colgante = 0;
+    for (double parcial : colgantes_por_hilo) {
+      colgante += parcial;
+    }
+
+    // Cada vértice "tira" de sus predecesores: no hay escrituras compartidas.
+    double base = (1 - amortiguacion) / cantidad + amortiguacion * colgante / cantidad;
+    para_cada_bloque(cantidad, hilos, [this, &puntaje, &siguiente, &peso_salida, base, amortiguacion](unsigned, size_t desde, size_t hasta) {
+      for (size_t v = desde; v < hasta; v++) {
+        double recibido = 0;
+        for (size_t e = _inicio_entrantes[v]; e < _inicio_entrantes[v + 1]; e++) {
+          unsigned u = _origenes[e];
+          recibido += puntaje[u] * _cantidades_entrantes[e] / peso_salida[u];
+        }
+        siguiente[v] = base + amortiguacion * recibido;
+      }
+    });
+
+    puntaje.swap(siguiente);
+  }
+
+  return puntaje;
+}
+
+vector<GrafoTransacciones::Flujo> GrafoTransacciones::flujos_mas_pesados(size_t k, unsigned hilos) const {
+  // Cada hilo se queda con sus k aristas más pesadas en un heap de mínimo y
+  // al final se combinan.
+  vector<vector<Flujo>> parciales(hilos_a_usar(hilos));
+  para_cada_bloque(cantidad_vertices(), hilos, [this, &parciales, k](unsigned h, size_t desde, size_t hasta) {
+    vector<Flujo>& heap = parciales[h];
+    for (size_t u = desde; u < hasta; u++) {
+      for (size_t e = _inicio_salientes[u]; e < _inicio_salientes[u + 1]; e++) {
+        Flujo flujo = {_billeteras[u], _billeteras[_destinos[e]], _cantidades[e], _montos[e]};
+        if (heap.size() < k) {
+          heap.push_back(flujo);
+          push_heap(heap.begin(), heap.end(), mas_pesado);
+        } else if (k > 0 && flujo.monto > heap.front().monto) {
+          pop_heap(heap.begin(), heap.end(), mas_pesado);
+          heap.back() = flujo;
+          push_heap(heap.begin(), heap.end(), mas_pesado);
+        }
+      }
+    }
+  });
+
+  vector<Flujo> ret;
+  for (auto it = parciales.begin(); it != parciales.end(); ++it) {
+    ret.insert(ret.end(), it->begin(), it->end());
+  }
+  sort(ret.begin(), ret.end(), mas_pesado);
+  if (ret.size() > k) {
+    ret.resize(k);
+  }
+  return ret;
+}
+
+map<size_t, size_t> GrafoTransacciones::distribucion_grados_salida(unsigned hilos) const {
+  return _distribucion_grados(_inicio_salientes, hilos);
+}
+
+map<size_t, size_t> GrafoTransacciones::distribucion_grados_entrada(unsigned hilos) const {
+  return _distribucion_grados(_inicio_entrantes, hilos);
+}
+
+
+/** Métodos privados auxiliares */
+
+void GrafoTransacciones::_construir(const vector<Transaccion>& transferencias, unsigned hilos) {
+  ordenar_en_paralelo(_billeteras, hilos, less<id_billetera>());
+  _billeteras.erase(unique(_billeteras.begin(), _billeteras.end()), _billeteras.end());
+
+  vector<Transferencia> aristas(transferencias.size());
+  para_cada_bloque(transferencias.size(), hilos, [this, &transferencias, &aristas](unsigned, size_t desde, size_t hasta) {
+    for (size_t i = desde; i < hasta; i++) {
+      aristas[i].origen = vertice(transferencias[i].origen);
+      aristas[i].destino = vertice(transferencias[i].destino);
+      aristas[i].monto = transferencias[i].monto;
+    }
+  });
+
+  ordenar_en_paralelo(aristas, hilos, menor_por_vertices);
+
+  // Agrupamos las transferencias repetidas en una única arista y contamos
+  // las aristas salientes de cada vértice.
+  size_t cantidad = _billeteras.size();
+  _inicio_salientes.assign(cantidad + 1, 0);
+  for (size_t i = 0; i < aristas.size(); i++) {
+    bool repetida = i > 0 && aristas[i].origen == aristas[i - 1].origen && aristas[i].destino == aristas[i - 1].destino;
+    if (repetida) {
+      _cantidades.back()++;
+      _montos.back() += aristas[i].monto;
+    } else {
+      _destinos.push_back(aristas[i].destino);
+      _cantidades.push_back(1);
+      _montos.push_back(aristas[i].monto);
+      _inicio_salientes[aristas[i].origen + 1]++;
+    }
+  }
+  for (size_t u = 0; u < cantidad; u++) {
+    _inicio_salientes[u + 1] += _inicio_salientes[u];
+  }
+
+  // Grafo traspuesto: counting sort de las aristas por destino. Recorriendo
+  // los orígenes en orden, cada grupo queda ordenado por origen.
+  _inicio_entrantes.assign(cantidad + 1, 0);
+  for (size_t e = 0; e < _destinos.size(); e++) {
+    _inicio_entrantes[_destinos[e] + 1]++;
+  }
+  for (size_t v = 0; v < cantidad; v++) {
+    _inicio_entrantes[v + 1] += _inicio_entrantes[v];
+  }
+
+  _origenes.resize(_destinos.size());
+  _cantidades_entrantes.resize(_destinos.size());
+  vector<size_t> siguiente(_inicio_entrantes.begin(), _inicio_entrantes.end() - 1);
+  for (size_t u = 0; u < cantidad; u++) {
+    for (size_t e = _inicio_salientes[u]; e < _inicio_salientes[u + 1]; e++) {
+      size_t posicion = siguiente[_destinos[e]]++;
+      _origenes[posicion] = u;
+      _cantidades_entrantes[posicion] = _cantidades[e];
+    }
+  }
+}
+
+map<size_t, size_t> GrafoTransacciones::_distribucion_grados(const vector<size_t>& inicios, unsigned hilos) const {
+  vector<map<size_t, size_t>> parciales(hilos_a_usar(hilos));
+  para_cada_bloque(cantidad_vertices(), hilos, [&inicios, &parciales](unsigned h, size_t desde, size_t hasta) {
+    for (size_t v = desde; v < hasta; v++) {
+      parciales[h][inicios[v + 1] - inicios[v]]++;
+    }
+  });
+
+  map<size_t, size_t> ret;
+  for (auto it = parciales.begin(); it != parciales.end(); ++it) {
+    for (auto grado = it->begin(); grado != it->end(); ++grado) {
+      ret[grado->first] += grado->second;
+    }
+  }
+  return ret;
+}
@@ -0,0 +1,179 @@
+#ifndef GRAFO_TRANSACCIONES_H
+#define GRAFO_TRANSACCIONES_H
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include "lib.h"
+#include "memoria.h"
+
+using namespace std;
+
+/**
+ * Grafo dirigido de transferencias entre billeteras, en formato CSR
+ * (compressed sparse row).
+ *
+ * Los vértices son las billeteras (numeradas de 0 a V-1 en orden creciente de
+ * id) y hay una arista u -> v si u le transfirió a v al menos una vez. Cada
+ * arista guarda la cantidad de transferencias y el monto total. Las
+ * transacciones semilla no generan aristas, pero sí registran a la billetera
+ * como vértice.
+ *
+ * Además de las aristas salientes se guardan las entrantes (el grafo
+ * traspuesto), que usan los algoritmos que "tiran" de los predecesores.
+ *
+ * Los algoritmos reciben la cantidad de hilos a usar (0 = todos los núcleos).
+ *
+ * INVARIANTE DE REPRESENTACIÓN:
+ *  - `_billeteras` está ordenado de forma estrictamente creciente.
+ *  - `_inicio_salientes` tiene V+1 elementos, empieza en 0, es no decreciente
+ *    y termina en la cantidad de aristas E. Las aristas salientes de u son las
+ *    posiciones [_inicio_salientes[u], _inicio_salientes[u+1]) de `_destinos`,
+ *    `_cantidades` y `_montos`, ordenadas por destino y sin repetidos.
+ *  - `_inicio_entrantes` / `_origenes` / `_cantidades_entrantes` describen el
+ *    mismo conjunto de aristas, agrupadas por destino.
+ */
+class GrafoTransacciones {
+  public:
+    /** Una arista del grafo, con ids de billetera. */
+    struct Flujo {
+      id_billetera origen;
+      id_billetera destino;
+      unsigned cantidad;
+      double monto;
+    };
+
+    /**
+     * Construye el grafo a partir de un listado de transacciones. El
+     * ordenamiento de las aristas se hace en paralelo.
+     *
+     * Complejidad: O(T * log(T) / H + T), donde H es la cantidad de hilos.
+     */
+    template <typename Asignador>
+    GrafoTransacciones(const list<Transaccion, Asignador>& transacciones, unsigned hilos = 0) {
+      // El listado no tiene acceso aleatorio: lo copiamos una vez y de acá en
+      // más trabajamos sobre vectores.
+      vector<Transaccion> transferencias;
+      for (auto it = transacciones.begin(); it != transacciones.end(); ++it) {
+        _billeteras.push_back(it->destino);
+        if (it->origen != 0) {
+          _billeteras.push_back(it->origen);
+          transferencias.push_back(*it);
+        }
+      }
+      _construir(transferencias, hilos);
+    }
+
+    /** Cantidad de vértices (billeteras). */
+    size_t cantidad_vertices() const;
+
+    /** Cantidad de aristas (pares origen-destino distintos). */
+    size_t cantidad_aristas() const;
+
+    /** Id de la billetera del vértice `v`. */
+    id_billetera billetera(size_t v) const;
+
+    /**
+     * Vértice de la billetera `id`, o `cantidad_vertices()` si no está.
+     *
+     * Complejidad: O(log(V))
+     */
+    size_t vertice(id_billetera id) const;
+
+    /** Cantidad de billeteras distintas a las que transfirió `v`. */
+    size_t grado_salida(size_t v) const;
+
+    /** Cantidad de billeteras distintas que le transfirieron a `v`. */
+    size_t grado_entrada(size_t v) const;
+
+    /**
+     * Recorrido BFS sobre las aristas salientes desde la billetera `origen`.
+     * Devuelve la distancia de cada vértice, o -1 si no es alcanzable.
+     *
+     * Cada nivel se procesa en paralelo.
+     *
+     * Complejidad: O((V + E) / H + profundidad)
+     */
+    vector<int> bfs(id_billetera origen, unsigned hilos = 0) const;
+
+    /**
+     * Componentes débilmente conexas (ignorando la dirección de las
+     * aristas). Devuelve, para cada vértice, el menor vértice de su
+     * componente.
+     *
+     * Union-find en paralelo: cada arista engancha la raíz mayor de sus
+     * extremos a la menor con compare-and-swap, y las búsquedas de raíz
+     * acortan los caminos a la mitad ("path halving") a medida que los
+     * recorren.
+     *
+     * Complejidad: O((V + E) * log(V) / H) en el peor caso, y casi lineal en
+     * la práctica
+     */
+    vector<size_t> componentes_conexas(unsigned hilos = 0) const;
+
+    /**
+     * Componentes fuertemente conexas (algoritmo de Tarjan, secuencial).
+     * Devuelve, para cada vértice, el número de su componente. Toda billetera
+     * cuya componente tiene más de un vértice participa de algún ciclo de
+     * transferencias.
+     *
+     * Complejidad: O(V + E)
+     */
+    vector<size_t> componentes_fuertemente_conexas() const;
+
+    /**
+     * Ranking tipo PageRank, donde cada billetera reparte su puntaje entre
+     * sus destinatarios en proporción a la cantidad de transferencias. El
+     * puntaje de billeteras sin aristas salientes se reparte uniformemente.
+     *
+     * Cada iteración se calcula en paralelo.
+     *
+     * Complejidad: O(iteraciones * (V + E) / H)
+     */
+    vector<double> ranking(unsigned iteraciones = 20, double amortiguacion = 0.85, unsigned hilos = 0) const;
+
+    /**
+     * Las `k` aristas de mayor monto total, de mayor a menor.
+     *
+     * Complejidad: O(E * log(k) / H + H * k * log(k))
+     */
+    vector<Flujo> flujos_mas_pesados(size_t k, unsigned hilos = 0) const;
+
+    /**
+     * Histograma de grados de salida: para cada grado, cuántos vértices lo
+     * tienen.
+     */
+    map<size_t, size_t> distribucion_grados_salida(unsigned hilos = 0) const;
+
+    /**
+     * Histograma de grados de entrada: para cada grado, cuántos vértices lo
+     * tienen.
+     */
+    map<size_t, size_t> distribucion_grados_entrada(unsigned hilos = 0) const;
+
+  private:
+    vector<id_billetera> _billeteras;
+
+    vector<size_t> _inicio_salientes;
+    vector<unsigned> _destinos;
+    vector<unsigned> _cantidades;
+    vector<double> _montos;
+
+    vector<size_t> _inicio_entrantes;
+    vector<unsigned> _origenes;
+    vector<unsigned> _cantidades_entrantes;
+
+    /** Métodos auxiliares */
+
+    /**
+     * Arma el grafo a partir de las transferencias (transacciones que no son
+     * semilla), con `_billeteras` ya cargado con los ids involucrados, con
+     * repetidos y sin ordenar.
+     */
+    void _construir(const vector<Transaccion>& transferencias, unsigned hilos);
+
+    map<size_t, size_t> _distribucion_grados(const vector<size_t>& inicios, unsigned hilos) const;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include <cmath>
+#include <cstring>
+
+#include "historial_comprimido.h"
+
+using namespace std;
+
+namespace {
+
+const uint64_t BIT_ENTRANTE = 1;
+const uint64_t BIT_MONTO_ENTERO = 2;
+
+uint64_t zigzag(int64_t valor) {
+  return (static_cast<uint64_t>(valor) << 1) ^ static_cast<uint64_t>(valor >> 63);
+}
+
+int64_t deshacer_zigzag(uint64_t valor) {
+  return static_cast<int64_t>(valor >> 1) ^ -static_cast<int64_t>(valor & 1);
+}
+
+uint64_t leer_varint(const uint8_t*& p) {
+  uint64_t ret = 0;
+  int corrimiento = 0;
+  while (*p & 0x80) {
+    ret |= static_cast<uint64_t>(*p & 0x7f) << corrimiento;
+    corrimiento += 7;
+    p++;
+  }
+  ret |= static_cast<uint64_t>(*p) << corrimiento;
+  p++;
+  return ret;
+}
+
+bool es_entero_de_32_bits(double monto) {
+  return monto >= 0 && monto <= 4294967295.0 && monto == floor(monto);
+}
+
+}
+
+HistorialComprimido::HistorialComprimido(id_billetera propietario, size_t* bytes)
+  : _propietario(propietario)
+  , _datos(AsignadorContado<uint8_t>(bytes))
+  , _bloques(AsignadorContado<Cabecera>(bytes))
+  , _cantidad(0)
+  , _contraparte_anterior(0)
+  , _timestamp_anterior(0) {
+}
+
+void HistorialComprimido::agregar(Transaccion t) {
+  bool entrante = t.destino == _propietario; // O(1)
+  id_billetera contraparte = entrante ? t.origen : t.destino; // O(1)
+
+  // Cada bloque arranca con sus propios valores base.
+  if (_cantidad % TRANSACCIONES_POR_BLOQUE == 0) {
+    _bloques.push_back({_datos.size(), t._timestamp, contraparte}); // O(1) amortizado
+    _contraparte_anterior = contraparte;
+    _timestamp_anterior = t._timestamp;
+  }
+
+  bool monto_entero = es_entero_de_32_bits(t.monto); // O(1)
+  int64_t delta_contraparte = static_cast<int64_t>(contraparte) - _contraparte_anterior;
+  int64_t delta_timestamp = static_cast<int64_t>(t._timestamp) - _timestamp_anterior;
+
+  _escribir_varint((zigzag(delta_contraparte) << 2) | (monto_entero ? BIT_MONTO_ENTERO : 0) | (entrante ? BIT_ENTRANTE : 0)); // O(1)
+  _escribir_varint(zigzag(delta_timestamp)); // O(1)
+  if (monto_entero) {
+    _escribir_varint(static_cast<uint64_t>(t.monto)); // O(1)
+  } else {
+    uint8_t crudo[sizeof(double)];
+    memcpy(crudo, &t.monto, sizeof(double));
+    _datos.insert(_datos.end(), crudo, crudo + sizeof(double)); // O(1) amortizado
+  }
+
+  _contraparte_anterior = contraparte;
+  _timestamp_anterior = t._timestamp;
+  _cantidad++;
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(1) amortizado
+}
+
+size_t HistorialComprimido::cantidad() const {
+  return _cantidad;
+}
+
+vector<Transaccion> HistorialComprimido::ultimas(int k) const {
+  vector<Transaccion> ret;
+  vector<Transaccion> bloque;
+  size_t cantidad = k > 0 ? k : 0;
+
+  // Decodificamos bloques desde el último hacia atrás, hasta juntar k. Sólo
+  // el último bloque recorrido puede aportar menos transacciones de las que
+  // decodifica, así que el costo es O(k + TRANSACCIONES_POR_BLOQUE).
+  for (size_t i = _bloques.size(); i > 0 && ret.size() < cantidad; i--) {
+    _decodificar_bloque(i - 1, bloque);
+    for (auto it = bloque.rbegin(); it != bloque.rend() && ret.size() < cantidad; ++it) {
+      ret.push_back(*it);
+    }
+  }
+
+  return ret;
+}
+
+size_t HistorialComprimido::bytes() const {
+  return _datos.capacity() * sizeof(uint8_t) + _bloques.capacity() * sizeof(Cabecera);
+}
+
+
+/** Métodos privados auxiliares */
+
+void HistorialComprimido::_escribir_varint(uint64_t valor) {
+  while (valor >= 0x80) {
+    _datos.push_back(static_cast<uint8_t>(valor) | 0x80);
+    valor >>= 7;
+  }
+  _datos.push_back(static_cast<uint8_t>(valor));
+}
+
+void HistorialComprimido::_decodificar_bloque(size_t bloque, vector<Transaccion>& salida) const {
+  const Cabecera& cabecera = _bloques[bloque];
+  size_t cantidad = bloque + 1 < _bloques.size() ? TRANSACCIONES_POR_BLOQUE : _cantidad - bloque * TRANSACCIONES_POR_BLOQUE;
+
+  salida.resize(cantidad);
+  const uint8_t* p = _datos.data() + cabecera.desplazamiento;
+  int64_t contraparte = cabecera.contraparte_base;
+  int64_t momento = cabecera.timestamp_base;
+
+  // Dentro del bloque la decodificación es secuencial: el largo de cada
+  // varint recién se conoce al leerlo, y de él depende dónde empieza el
+  // siguiente. Lo que no depende de nada anterior es cada bloque.
+  for (size_t i = 0; i < cantidad; i++) {
+    uint64_t encabezado = leer_varint(p);
+    contraparte += deshacer_zigzag(encabezado >> 2);
+    momento += deshacer_zigzag(leer_varint(p));
+
+    double monto;
+    if (encabezado & BIT_MONTO_ENTERO) {
+      monto = static_cast<double>(leer_varint(p));
+    } else {
+      memcpy(&monto, p, sizeof(double));
+      p += sizeof(double);
+    }
+
+    id_billetera otra = static_cast<id_billetera>(contraparte);
+    if (encabezado & BIT_ENTRANTE) {
+      salida[i] = {otra, _propietario, monto, static_cast<timestamp>(momento)};
+    } else {
+      salida[i] = {_propietario, otra, monto, static_cast<timestamp>(momento)};
+    }
+  }
+}
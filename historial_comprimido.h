@@ -0,0 +1,112 @@
+#ifndef HISTORIAL_COMPRIMIDO_H
+#define HISTORIAL_COMPRIMIDO_H
+
+#include <cstdint>
+#include <vector>
+
+#include "lib.h"
+#include "memoria.h"
+
+using namespace std;
+
+/**
+ * Historial de transacciones de una billetera, codificado de forma compacta.
+ *
+ * Como todas las transacciones involucran a la billetera propietaria, cada
+ * una se guarda desde su punto de vista:
+ *   - un varint con la diferencia de contraparte respecto de la transacción
+ *     anterior (en zigzag), un bit de dirección (entrante / saliente) y un bit
+ *     que indica si el monto es entero,
+ *   - un varint con la diferencia de timestamp respecto de la transacción
+ *     anterior (en zigzag, ya que pueden llegar fuera de orden),
+ *   - el monto como varint si es un entero de 32 bits, o los 8 bytes del
+ *     double si no.
+ *
+ * Las transacciones se agrupan en bloques de TRANSACCIONES_POR_BLOQUE. Cada
+ * bloque tiene una cabecera con su desplazamiento y los valores base de
+ * timestamp y contraparte, así que se puede decodificar sin mirar los
+ * bloques anteriores. En el caso típico una transacción ocupa 4 a 6 bytes.
+ *
+ * INVARIANTE DE REPRESENTACIÓN:
+ *  - `_bloques` tiene ceil(_cantidad / TRANSACCIONES_POR_BLOQUE) cabeceras,
+ *    con desplazamientos crecientes dentro de `_datos`.
+ *  - El bloque i codifica las transacciones [i * TRANSACCIONES_POR_BLOQUE,
+ *    (i + 1) * TRANSACCIONES_POR_BLOQUE) en orden de llegada, con las
+ *    diferencias de la primera medidas contra los valores base del bloque.
+ *  - `_contraparte_anterior` y `_timestamp_anterior` son los de la última
+ *    transacción agregada.
+ */
+class HistorialComprimido {
+  public:
+    /** Cantidad de transacciones por bloque. */
+    static const size_t TRANSACCIONES_POR_BLOQUE = 32;
+
+    /**
+     * Constructor. `propietario` es la billetera dueña del historial. Si se
+     * pasa `bytes`, ahí se lleva la cuenta de la memoria que ocupa.
+     */
+    explicit HistorialComprimido(id_billetera propietario, size_t* bytes = nullptr);
+
+    /**
+     * Agrega una transacción al final. Precondición: `propietario` es origen o
+     * destino de la transacción.
+     *
+     * Complejidad: O(1) amortizado.
+     */
+    void agregar(Transaccion t);
+
+    /** Cantidad de transacciones guardadas. */
+    size_t cantidad() const;
+
+    /**
+     * Devuelve las últimas `k` transacciones, de la más reciente a la más
+     * antigua.
+     *
+     * Complejidad: O(k + TRANSACCIONES_POR_BLOQUE)
+     */
+    vector<Transaccion> ultimas(int k) const;
+
+    /**
+     * Llama a `f` con cada transacción, en orden de llegada.
+     *
+     * Complejidad: O(T)
+     */
+    template <typename F>
+    void para_cada(F f) const {
+      vector<Transaccion> bloque;
+      for (size_t i = 0; i < _bloques.size(); i++) {
+        _decodificar_bloque(i, bloque);
+        for (auto it = bloque.begin(); it != bloque.end(); ++it) {
+          f(*it);
+        }
+      }
+    }
+
+    /** Bytes reservados por el historial (datos codificados y cabeceras). */
+    size_t bytes() const;
+
+  private:
+    struct Cabecera {
+      /** Posición del bloque en `_datos`; de 64 bits para historiales de más de 4 GiB. */
+      uint64_t desplazamiento;
+      timestamp timestamp_base;
+      id_billetera contraparte_base;
+    };
+
+    id_billetera _propietario;
+
+    vector<uint8_t, AsignadorContado<uint8_t>> _datos;
+    vector<Cabecera, AsignadorContado<Cabecera>> _bloques;
+    size_t _cantidad;
+
+    id_billetera _contraparte_anterior;
+    timestamp _timestamp_anterior;
+
+    /** Métodos auxiliares */
+
+    void _escribir_varint(uint64_t valor);
+
+    void _decodificar_bloque(size_t bloque, vector<Transaccion>& salida) const;
+};
+
+#endif
@@ -13,4 +13,14 @@ struct Transaccion {
     timestamp _timestamp;
 };
 
+// Pide al procesador que vaya trayendo `direccion` a la caché, sin esperar a
+// que llegue. En compiladores que no lo soportan no hace nada.
+inline void anticipar_lectura(const void* direccion) {
+#if defined(__GNUC__)
+    __builtin_prefetch(direccion, 0, 3);
+#else
+    (void) direccion;
+#endif
+}
+
 #endif // LIB_H_
@@ -0,0 +1,103 @@
+#ifndef MEMORIA_H_
+#define MEMORIA_H_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+
+#include "lib.h"
+
+/*
+ * Asignador que suma en `*contador` los bytes que pide el contenedor y resta
+ * los que libera. Con contador nulo no cuenta nada.
+ *
+ * Dos asignadores son iguales si comparten contador, así que sólo se pueden
+ * mover nodos (`splice`, asignación por movimiento sin copiar) entre
+ * contenedores que cuentan en el mismo lugar. El asignador no se propaga en
+ * las asignaciones: un contenedor cuenta siempre donde se construyó.
+ *
+ * El contador no es atómico: lo modifica sólo quien modifica el contenedor.
+ */
+template <typename T>
+class AsignadorContado {
+  public:
+    typedef T value_type;
+
+    AsignadorContado() noexcept : _contador(nullptr) {}
+
+    explicit AsignadorContado(size_t* contador) noexcept : _contador(contador) {}
+
+    template <typename U>
+    AsignadorContado(const AsignadorContado<U>& otro) noexcept : _contador(otro.contador()) {}
+
+    T* allocate(size_t n) {
+      T* memoria = std::allocator<T>().allocate(n);
+      if (_contador != nullptr) {
+        *_contador += n * sizeof(T);
+      }
+      return memoria;
+    }
+
+    void deallocate(T* memoria, size_t n) noexcept {
+      if (_contador != nullptr) {
+        *_contador -= n * sizeof(T);
+      }
+      std::allocator<T>().deallocate(memoria, n);
+    }
+
+    size_t* contador() const noexcept {
+      return _contador;
+    }
+
+  private:
+    size_t* _contador;
+};
+
+template <typename T, typename U>
+bool operator==(const AsignadorContado<T>& a, const AsignadorContado<U>& b) noexcept {
+  return a.contador() == b.contador();
+}
+
+template <typename T, typename U>
+bool operator!=(const AsignadorContado<T>& a, const AsignadorContado<U>& b) noexcept {
+  return !(a == b);
+}
+
+/* Listado de transacciones de una blockchain, con su memoria contada. */
+typedef std::list<Transaccion, AsignadorContado<Transaccion>> ListaTransacciones;
+
+/*
+ * Bytes que ocupa una billetera, por estructura. Salvo `objeto`, cada campo
+ * es el contador del asignador de la estructura correspondiente.
+ */
+struct MemoriaBilletera {
+  /** El objeto Billetera en sí, sin la memoria dinámica de sus estructuras. */
+  size_t objeto = 0;
+
+  /** Historial comprimido. */
+  size_t historial = 0;
+
+  /** Árbol de saldos por día, incluidos los días sin movimientos. */
+  size_t saldo_por_dia = 0;
+
+  /** Destinatarios agrupados por cantidad de envíos. */
+  size_t destinatarios = 0;
+
+  /** Envíos por destinatario dentro de la ventana. */
+  size_t destinatarios_en_ventana = 0;
+
+  size_t total() const {
+    return objeto + historial + saldo_por_dia + destinatarios + destinatarios_en_ventana;
+  }
+
+  MemoriaBilletera& operator+=(const MemoriaBilletera& otra) {
+    objeto += otra.objeto;
+    historial += otra.historial;
+    saldo_por_dia += otra.saldo_por_dia;
+    destinatarios += otra.destinatarios;
+    destinatarios_en_ventana += otra.destinatarios_en_ventana;
+    return *this;
+  }
+};
+
+#endif // MEMORIA_H_
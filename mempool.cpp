@@ -0,0 +1,160 @@
+#include "mempool.h"
+#include "blockchain.h"
+#include "billetera.h"
+#include "traza.h"
+
+using namespace std;
+
+Mempool::Mempool(Blockchain* blockchain) : _blockchain(blockchain) {
+  _siguiente_id = 1;
+}
+
+Mempool::id_pendiente Mempool::encolar(Billetera* origen, id_billetera destino, double monto, unsigned prioridad) {
+  id_pendiente id = _siguiente_id++; // O(1)
+
+  Pendiente pendiente = {origen, destino, monto, prioridad};
+  _pendientes.emplace(id, pendiente); // O(1) amortizado
+
+  Clave clave = {prioridad, id};
+  _modificar_cadena(origen->id(), [&clave](Cadena& cadena) {
+    cadena.pendientes.insert(clave); // O(log(n))
+  });
+
+  return id;
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(log(n))
+}
+
+bool Mempool::cancelar(id_pendiente id) {
+  auto it = _pendientes.find(id); // O(1) promedio
+  if (it == _pendientes.end()) {
+    return false;
+  }
+
+  Clave clave = {it->second.prioridad, id};
+  _modificar_cadena(it->second.origen->id(), [&clave](Cadena& cadena) {
+    cadena.pendientes.erase(clave); // O(log(n))
+  });
+  _pendientes.erase(it); // O(1)
+
+  return true;
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(log(n))
+}
+
+bool Mempool::pendiente(id_pendiente id) const {
+  return _pendientes.count(id) > 0;
+}
+
+size_t Mempool::cantidad() const {
+  return _pendientes.size();
+}
+
+Mempool::Lote Mempool::confirmar(size_t maximo) {
+  TramoTraza tramo("confirmar_lote");
+
+  Lote lote;
+  size_t revisadas = 0;
+  unsigned long long ultimo_ticket = 0;
+
+  while (lote.confirmadas.size() < maximo && !_listas.empty()) {
+    revisadas++;
+
+    Clave cabeza = *_listas.begin(); // O(1)
+    auto it = _pendientes.find(cabeza.id); // O(1) promedio
+    Pendiente pendiente = it->second;
+    id_billetera origen = pendiente.origen->id();
+
+    // Sin saldo, la cadena espera entera: las siguientes pendientes del
+    // origen no se adelantan a su cabeza. `saldo()` es el mismo saldo
+    // truncado con el que valida la blockchain.
+    if (pendiente.origen->saldo() < pendiente.monto) {
+      _listas.erase(_listas.begin()); // O(1) amortizado
+      _cadenas.find(origen)->second.bloqueada = true; // O(log(n))
+      continue;
+    }
+
+    unsigned long long ticket = _blockchain->agregar_sin_esperar(pendiente.origen, pendiente.destino, pendiente.monto); // O(A)
+
+    _modificar_cadena(origen, [](Cadena& cadena) {
+      cadena.pendientes.erase(cadena.pendientes.begin()); // O(1) amortizado
+    });
+    _pendientes.erase(it); // O(1)
+
+    if (ticket != 0) {
+      lote.confirmadas.push_back(cabeza.id);
+      ultimo_ticket = ticket;
+
+      // Lo recibido puede alcanzar para la cabeza bloqueada del destino.
+      _desbloquear(pendiente.destino); // O(log(n))
+    } else {
+      lote.descartadas.push_back(cabeza.id);
+    }
+  }
+
+  if (ultimo_ticket != 0) {
+    lote.durable = _blockchain->esperar_durable(ultimo_ticket);
+  }
+
+  tramo.argumento("revisadas", revisadas);
+  tramo.argumento("confirmadas", lote.confirmadas.size());
+
+  return lote;
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(r * (log(n) + A))
+}
+
+void Mempool::reintentar_bloqueadas() {
+  for (auto it = _cadenas.begin(); it != _cadenas.end(); ++it) {
+    if (it->second.bloqueada) {
+      it->second.bloqueada = false;
+      _listas.insert(*it->second.pendientes.begin()); // O(log(n))
+    }
+  }
+
+  // COMPLEJIDAD TOTAL DEL MÉTODO: O(c * log(n))
+}
+
+
+/** Métodos privados auxiliares */
+
+template <typename F>
+void Mempool::_modificar_cadena(id_billetera origen, F cambio) {
+  auto it = _cadenas.find(origen); // O(log(n))
+  if (it == _cadenas.end()) {
+    it = _cadenas.emplace(origen, Cadena()).first; // O(log(n))
+  }
+  Cadena& cadena = it->second;
+
+  bool habia_cabeza = !cadena.pendientes.empty();
+  Clave cabeza_anterior = habia_cabeza ? *cadena.pendientes.begin() : Clave();
+
+  cambio(cadena);
+
+  bool hay_cabeza = !cadena.pendientes.empty();
+  bool misma_cabeza = habia_cabeza && hay_cabeza && cadena.pendientes.begin()->id == cabeza_anterior.id;
+  if (misma_cabeza) {
+    return;
+  }
+
+  if (habia_cabeza && !cadena.bloqueada) {
+    _listas.erase(cabeza_anterior); // O(log(n))
+  }
+
+  if (!hay_cabeza) {
+    _cadenas.erase(it); // O(1) amortizado
+    return;
+  }
+
+  // Con otra cabeza, el bloqueo de la anterior ya no aplica.
+  cadena.bloqueada = false;
+  _listas.insert(*cadena.pendientes.begin()); // O(log(n))
+}
+
+void Mempool::_desbloquear(id_billetera origen) {
+  auto it = _cadenas.find(origen); // O(log(n))
+  if (it != _cadenas.end() && it->second.bloqueada) {
+    it->second.bloqueada = false;
+    _listas.insert(*it->second.pendientes.begin()); // O(log(n))
+  }
+}
@@ -0,0 +1,167 @@
+#ifndef MEMPOOL_H
+#define MEMPOOL_H
+
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "lib.h"
+
+using namespace std;
+
+class Billetera;
+class Blockchain;
+
+/**
+ * Transferencias pendientes delante de una `Blockchain`, que se confirman
+ * por lotes en orden de prioridad a medida que los orígenes tienen saldo.
+ *
+ * Las pendientes de cada billetera origen forman una cadena ordenada por
+ * prioridad (mayor primero) y, a igual prioridad, por orden de llegada. Una
+ * cadena sólo avanza por su cabeza: si la cabeza no tiene saldo, la cadena
+ * queda bloqueada (sin saltear a las siguientes, aunque sean más chicas)
+ * hasta que el origen reciba una transferencia confirmada por el mempool, o
+ * cambie su cabeza, o se llame a `reintentar_bloqueadas`.
+ *
+ * `confirmar` toma siempre la cabeza de mayor prioridad entre las cadenas no
+ * bloqueadas, revalida contra el saldo actual del origen y la agrega a la
+ * blockchain.
+ *
+ * Los montos pueden ser fraccionarios, pero los saldos son enteros: tanto
+ * `Billetera::saldo` como `Blockchain::calcular_saldo` (con el que valida la
+ * blockchain) truncan el saldo transacción por transacción, en el mismo
+ * orden. Por eso la revalidación con `saldo()` bloquea exactamente las
+ * cabezas que la blockchain rechazaría por saldo, sin recorrer el listado.
+ *
+ * El id de cada pendiente es su número de llegada.
+ *
+ * INVARIANTE DE REPRESENTACIÓN:
+ *  - Cada pendiente de `_pendientes` está en la cadena de su origen, y cada
+ *    clave de una cadena es de una pendiente de `_pendientes`.
+ *  - No hay cadenas vacías en `_cadenas`.
+ *  - `_listas` tiene exactamente las cabezas de las cadenas no bloqueadas.
+ */
+class Mempool {
+  public:
+    typedef unsigned long long id_pendiente;
+
+    /** Pendientes resueltas por un llamado a `confirmar`. */
+    struct Lote {
+      /** Impactadas en la blockchain, en orden de confirmación. */
+      vector<id_pendiente> confirmadas;
+
+      /**
+       * Rechazadas por la blockchain aunque el origen tenía saldo (destino
+       * desconocido, origen que no es de la blockchain, registro persistente
+       * fallado, etc.). No se impactaron, y se quitan del mempool.
+       */
+      vector<id_pendiente> descartadas;
+
+      /**
+       * Con registro persistente, `false` si falló la escritura de alguna de
+       * las confirmadas: quedaron impactadas en memoria pero no son durables.
+       */
+      bool durable = true;
+    };
+
+    /** Constructor. No toma posesión de la blockchain. */
+    explicit Mempool(Blockchain* blockchain);
+
+    /**
+     * Encola una transferencia con la prioridad dada (mayor se confirma
+     * antes) y devuelve su id. No valida nada: se valida al confirmar.
+     *
+     * Complejidad: O(log(n)), donde n es la cantidad de pendientes
+     */
+    id_pendiente encolar(Billetera* origen, id_billetera destino, double monto, unsigned prioridad);
+
+    /**
+     * Quita una pendiente. Devuelve `false` si no estaba (ya se confirmó, se
+     * descartó o se canceló).
+     *
+     * Complejidad: O(log(n))
+     */
+    bool cancelar(id_pendiente id);
+
+    /** Indica si la pendiente sigue en el mempool. */
+    bool pendiente(id_pendiente id) const;
+
+    /** Cantidad de pendientes. */
+    size_t cantidad() const;
+
+    /**
+     * Confirma pendientes en orden de prioridad hasta agregar `maximo` a la
+     * blockchain o hasta que no quede ninguna cadena desbloqueada. Una
+     * confirmación que acredita a un origen bloqueado lo desbloquea, así que
+     * sus pendientes se reintentan dentro del mismo lote.
+     *
+     * Las confirmadas se agregan sin esperar a que cada una sea durable, y
+     * se espera una sola vez al final: con registro persistente, el lote se
+     * escribe en pocos grupos en lugar de uno por transacción.
+     *
+     * Complejidad: O(r * (log(n) + A)), donde r es la cantidad de pendientes
+     * revisadas y A la complejidad de `Blockchain::agregar_transaccion`
+     */
+    Lote confirmar(size_t maximo);
+
+    /**
+     * Desbloquea todas las cadenas, por ejemplo luego de que sus orígenes
+     * recibieron transferencias por fuera del mempool.
+     *
+     * Complejidad: O(c * log(n)), donde c es la cantidad de cadenas
+     */
+    void reintentar_bloqueadas();
+
+  private:
+    /** Orden de las pendientes: mayor prioridad primero, y luego por llegada. */
+    struct Clave {
+      unsigned prioridad;
+      id_pendiente id;
+
+      bool operator<(const Clave& otra) const {
+        return prioridad > otra.prioridad || (prioridad == otra.prioridad && id < otra.id);
+      }
+    };
+
+    struct Pendiente {
+      Billetera* origen;
+      id_billetera destino;
+      double monto;
+      unsigned prioridad;
+    };
+
+    struct Cadena {
+      set<Clave> pendientes;
+      bool bloqueada = false;
+    };
+
+    Blockchain* const _blockchain;
+
+    id_pendiente _siguiente_id;
+
+    unordered_map<id_pendiente, Pendiente> _pendientes;
+
+    /** Cadena de pendientes de cada billetera origen. */
+    map<id_billetera, Cadena> _cadenas;
+
+    /** Cabezas de las cadenas no bloqueadas. */
+    set<Clave> _listas;
+
+    /** Métodos auxiliares */
+
+    /**
+     * Saca de `_listas` la cabeza actual de la cadena de `origen` (si
+     * estaba), aplica `cambio` a la cadena, y la vuelve a dejar lista (o la
+     * borra si quedó vacía). Si la cabeza cambió, la cadena se desbloquea.
+     *
+     * Complejidad: O(log(n)) más lo que cueste `cambio`
+     */
+    template <typename F>
+    void _modificar_cadena(id_billetera origen, F cambio);
+
+    /** Desbloquea la cadena de `origen`, si tiene una bloqueada. */
+    void _desbloquear(id_billetera origen);
+};
+
+#endif
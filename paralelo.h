@@ -0,0 +1,101 @@
+#ifndef PARALELO_H_
+#define PARALELO_H_
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/*
+ * Cantidad de hilos a usar cuando se pide `hilos`. Con 0 se usan todos los
+ * núcleos disponibles.
+ */
+inline unsigned hilos_a_usar(unsigned hilos) {
+  if (hilos == 0) {
+    hilos = std::thread::hardware_concurrency();
+  }
+  return hilos == 0 ? 1 : hilos;
+}
+
+/*
+ * Hilo que se espera al destruirse, así una excepción en el hilo que lo lanzó
+ * no deja un `std::thread` sin unir (que terminaría el programa).
+ */
+class HiloUnido {
+  public:
+    template <typename F>
+    explicit HiloUnido(F f) : _hilo(f) {}
+
+    /** Espera a que termine el hilo. */
+    void esperar() {
+      if (_hilo.joinable()) {
+        _hilo.join();
+      }
+    }
+
+    ~HiloUnido() {
+      esperar();
+    }
+
+    HiloUnido(const HiloUnido&) = delete;
+    HiloUnido& operator=(const HiloUnido&) = delete;
+
+  private:
+    std::thread _hilo;
+};
+
+/*
+ * Divide [0, n) en `hilos` bloques contiguos y llama a `f(hilo, desde, hasta)`
+ * para cada uno en paralelo. El primer bloque corre en el hilo que llama.
+ * Retorna cuando terminaron todos los bloques.
+ */
+template <typename F>
+void para_cada_bloque(size_t n, unsigned hilos, F f) {
+  hilos = std::max(1u, std::min<unsigned>(hilos_a_usar(hilos), n == 0 ? 1 : n));
+
+  std::vector<std::thread> trabajadores;
+  for (unsigned h = 1; h < hilos; h++) {
+    trabajadores.emplace_back(f, h, n * h / hilos, n * (h + 1) / hilos);
+  }
+  f(0u, size_t(0), n / hilos);
+
+  for (auto& trabajador : trabajadores) {
+    trabajador.join();
+  }
+}
+
+/*
+ * Ordena `v` en paralelo: cada hilo ordena un bloque y luego los bloques se
+ * mezclan de a pares, también en paralelo.
+ */
+template <typename T, typename Comparador>
+void ordenar_en_paralelo(std::vector<T>& v, unsigned hilos, Comparador menor) {
+  hilos = std::max(1u, std::min<unsigned>(hilos_a_usar(hilos), v.size() == 0 ? 1 : v.size()));
+
+  std::vector<size_t> limites;
+  for (unsigned h = 0; h <= hilos; h++) {
+    limites.push_back(v.size() * h / hilos);
+  }
+
+  para_cada_bloque(hilos, hilos, [&v, &limites, &menor](unsigned, size_t desde, size_t hasta) {
+    for (size_t b = desde; b < hasta; b++) {
+      std::sort(v.begin() + limites[b], v.begin() + limites[b + 1], menor);
+    }
+  });
+
+  // Cada ronda mezcla bloques vecinos y duplica el tamaño de los bloques.
+  for (size_t paso = 1; paso < hilos; paso *= 2) {
+    size_t mezclas = (hilos + 2 * paso - 1) / (2 * paso);
+    para_cada_bloque(mezclas, mezclas, [&v, &limites, &menor, paso, hilos](unsigned, size_t desde, size_t hasta) {
+      for (size_t m = desde; m < hasta; m++) {
+        size_t izquierda = m * 2 * paso;
+        size_t medio = std::min<size_t>(izquierda + paso, hilos);
+        size_t derecha = std::min<size_t>(izquierda + 2 * paso, hilos);
+        if (medio < derecha) {
+          std::inplace_merge(v.begin() + limites[izquierda], v.begin() + limites[medio], v.begin() + limites[derecha], menor);
+        }
+      }
+    });
+  }
+}
+
+#endif // PARALELO_H_
@@ -0,0 +1,177 @@
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "registro_persistente.h"
+#include "traza.h"
+
+using namespace std;
+
+RegistroPersistente::RegistroPersistente(const string& ruta)
+  : RegistroPersistente(ruta, Configuracion()) {
+}
+
+RegistroPersistente::RegistroPersistente(const string& ruta, Configuracion configuracion)
+  : _configuracion(configuracion)
+  , _siguiente_ticket(1)
+  , _ultimo_ticket_durable(0)
+  , _grupos_confirmados(0)
+  , _fallo_escritura(false)
+  , _detener(false) {
+  _archivo = open(ruta.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (_archivo < 0) {
+    throw runtime_error("no se pudo abrir el registro persistente: " + ruta);
+  }
+
+  _escritor = thread(&RegistroPersistente::_escribir_grupos, this);
+}
+
+unsigned long long RegistroPersistente::agregar(Transaccion transaccion) {
+  return agregar(transaccion, nullptr);
+}
+
+unsigned long long RegistroPersistente::agregar(Transaccion transaccion, function<void(bool)> al_confirmar) {
+  char registro[TAMANO_REGISTRO];
+  memcpy(registro, &transaccion.origen, 4);
+  memcpy(registro + 4, &transaccion.destino, 4);
+  memcpy(registro + 8, &transaccion.monto, 8);
+  memcpy(registro + 16, &transaccion._timestamp, 4);
+
+  lock_guard<mutex> lock(_mutex);
+  if (_pendientes.empty()) {
+    _inicio_grupo = chrono::steady_clock::now();
+  }
+  _pendientes.insert(_pendientes.end(), registro, registro + TAMANO_REGISTRO);
+  _callbacks_pendientes.push_back(move(al_confirmar));
+
+  // Despertamos al escritor con el primer registro del grupo (para que
+  // empiece a contar la ventana) y cuando se completó el tamaño del grupo.
+  if (_pendientes.size() == TAMANO_REGISTRO || _pendientes.size() >= _configuracion.bytes_por_grupo) {
+    _hay_pendientes.notify_one();
+  }
+
+  return _siguiente_ticket++;
+}
+
+bool RegistroPersistente::esperar(unsigned long long ticket) {
+  unique_lock<mutex> lock(_mutex);
+  _grupo_confirmado.wait(lock, [this, ticket]() { return _fallo_escritura || _ultimo_ticket_durable >= ticket; });
+
+  return _ultimo_ticket_durable >= ticket;
+}
+
+bool RegistroPersistente::fallo_escritura() {
+  lock_guard<mutex> lock(_mutex);
+  return _fallo_escritura;
+}
+
+unsigned long long RegistroPersistente::grupos_confirmados() {
+  lock_guard<mutex> lock(_mutex);
+  return _grupos_confirmados;
+}
+
+unsigned long long RegistroPersistente::transacciones_confirmadas() {
+  lock_guard<mutex> lock(_mutex);
+  return _ultimo_ticket_durable;
+}
+
+vector<Transaccion> RegistroPersistente::leer(const string& ruta) {
+  vector<Transaccion> ret;
+  ifstream archivo(ruta, ios::binary);
+
+  char registro[TAMANO_REGISTRO];
+  while (archivo.read(registro, TAMANO_REGISTRO)) {
+    Transaccion transaccion;
+    memcpy(&transaccion.origen, registro, 4);
+    memcpy(&transaccion.destino, registro + 4, 4);
+    memcpy(&transaccion.monto, registro + 8, 8);
+    memcpy(&transaccion._timestamp, registro + 16, 4);
+    ret.push_back(transaccion);
+  }
+
+  return ret;
+}
+
+RegistroPersistente::~RegistroPersistente() {
+  {
+    lock_guard<mutex> lock(_mutex);
+    _detener = true;
+  }
+  _hay_pendientes.notify_one();
+  _escritor.join();
+
+  close(_archivo);
+}
+
+
+/** Métodos privados auxiliares */
+
+void RegistroPersistente::_escribir_grupos() {
+  unique_lock<mutex> lock(_mutex);
+
+  while (true) {
+    _hay_pendientes.wait(lock, [this]() { return _detener || !_pendientes.empty(); });
+    if (_pendientes.empty()) {
+      return; // _detener y no queda nada por escribir
+    }
+
+    // Esperamos a que se sumen más transacciones al grupo, salvo que ya esté
+    // completo o nos estemos cerrando.
+    chrono::steady_clock::time_point limite = _inicio_grupo + _configuracion.ventana;
+    _hay_pendientes.wait_until(lock, limite, [this]() {
+      return _detener || _pendientes.size() >= _configuracion.bytes_por_grupo;
+    });
+
+    vector<char> grupo;
+    vector<function<void(bool)>> callbacks;
+    grupo.swap(_pendientes);
+    callbacks.swap(_callbacks_pendientes);
+    unsigned long long ultimo_ticket = _siguiente_ticket - 1;
+
+    // Mientras escribimos, las transacciones nuevas se acumulan en el
+    // próximo grupo.
+    lock.unlock();
+    bool escrito = _escribir_y_sincronizar(grupo);
+    lock.lock();
+
+    if (escrito && !_fallo_escritura) {
+      _ultimo_ticket_durable = ultimo_ticket;
+      _grupos_confirmados++;
+    } else {
+      _fallo_escritura = true;
+    }
+    bool confirmado = !_fallo_escritura;
+    _grupo_confirmado.notify_all();
+
+    lock.unlock();
+    for (auto it = callbacks.begin(); it != callbacks.end(); ++it) {
+      if (*it) {
+        (*it)(confirmado);
+      }
+    }
+    lock.lock();
+  }
+}
+
+bool RegistroPersistente::_escribir_y_sincronizar(const vector<char>& datos) {
+  TramoTraza tramo("escribir_grupo");
+  tramo.argumento("transacciones", datos.size() / TAMANO_REGISTRO);
+
+  size_t escritos = 0;
+  while (escritos < datos.size()) {
+    ssize_t n = write(_archivo, datos.data() + escritos, datos.size() - escritos);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return false;
+    }
+    escritos += n;
+  }
+
+  return fdatasync(_archivo) == 0;
+}
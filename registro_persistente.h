@@ -0,0 +1,143 @@
+#ifndef REGISTRO_PERSISTENTE_H
+#define REGISTRO_PERSISTENTE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lib.h"
+
+using namespace std;
+
+/**
+ * Registro de transacciones en disco con confirmación agrupada ("group
+ * commit").
+ *
+ * Las transacciones agregadas se acumulan en memoria y un hilo escritor las
+ * baja a disco con un único `write` + `fdatasync` por grupo. Un grupo se
+ * escribe cuando pasó `ventana` desde la primera transacción pendiente o
+ * cuando se juntaron `bytes_por_grupo` bytes, lo que ocurra primero. Quienes
+ * esperan una transacción se despiertan cuando su grupo es durable.
+ *
+ * Cada transacción ocupa TAMANO_REGISTRO bytes en el archivo:
+ * origen, destino, monto y timestamp, en el orden en que fueron agregadas.
+ *
+ * INVARIANTE DE REPRESENTACIÓN:
+ *  - Las transacciones con ticket menor o igual a `_ultimo_ticket_durable`
+ *    ya fueron escritas y sincronizadas.
+ *  - `_pendientes` contiene, en orden, los registros de los tickets en
+ *    (`_ultimo_ticket_durable`, `_siguiente_ticket`) que todavía no fueron
+ *    tomados por el hilo escritor.
+ */
+class RegistroPersistente {
+  public:
+    /** Perillas de latencia / throughput. */
+    struct Configuracion {
+      /**
+       * Tiempo máximo que una transacción espera a que se sumen otras a su
+       * grupo. Con 0 cada grupo se escribe apenas el escritor está libre.
+       */
+      chrono::microseconds ventana = chrono::microseconds(500);
+
+      /** Tamaño a partir del cual el grupo se escribe sin esperar la ventana. */
+      size_t bytes_por_grupo = 64 * 1024;
+    };
+
+    /** Bytes que ocupa cada transacción en el archivo. */
+    static const size_t TAMANO_REGISTRO = 20;
+
+    /**
+     * Abre (o crea) el archivo en `ruta` y agrega al final. Lanza
+     * `runtime_error` si no se pudo abrir.
+     */
+    explicit RegistroPersistente(const string& ruta);
+
+    RegistroPersistente(const string& ruta, Configuracion configuracion);
+
+    /**
+     * Encola la transacción para el próximo grupo y devuelve su ticket. No
+     * bloquea.
+     *
+     * Complejidad: O(1) amortizado.
+     */
+    unsigned long long agregar(Transaccion transaccion);
+
+    /**
+     * Igual que `agregar`, pero además llama a `al_confirmar` desde el hilo
+     * escritor cuando el grupo de la transacción es durable (con `true`) o
+     * falló la escritura (con `false`).
+     */
+    unsigned long long agregar(Transaccion transaccion, function<void(bool)> al_confirmar);
+
+    /**
+     * Bloquea hasta que la transacción con el ticket dado es durable.
+     * Devuelve `false` si la escritura a disco falló.
+     */
+    bool esperar(unsigned long long ticket);
+
+    /**
+     * Indica si falló alguna escritura. A partir de ahí ninguna transacción
+     * que se agregue va a ser durable.
+     */
+    bool fallo_escritura();
+
+    /** Cantidad de grupos escritos y sincronizados. */
+    unsigned long long grupos_confirmados();
+
+    /** Cantidad de transacciones escritas y sincronizadas. */
+    unsigned long long transacciones_confirmadas();
+
+    /**
+     * Lee todas las transacciones completas de un archivo escrito por un
+     * RegistroPersistente. Un registro final incompleto se ignora.
+     *
+     * Complejidad: O(T)
+     */
+    static vector<Transaccion> leer(const string& ruta);
+
+    /**
+     * Destructor. Escribe lo pendiente y cierra el archivo.
+     */
+    ~RegistroPersistente();
+
+  private:
+    const Configuracion _configuracion;
+
+    /** Descriptor del archivo. */
+    int _archivo;
+
+    /** Registros codificados que esperan al próximo grupo. */
+    vector<char> _pendientes;
+
+    /** Callbacks de los registros pendientes, en orden. */
+    vector<function<void(bool)>> _callbacks_pendientes;
+
+    /** Momento en que se agregó el primer registro pendiente. */
+    chrono::steady_clock::time_point _inicio_grupo;
+
+    unsigned long long _siguiente_ticket;
+    unsigned long long _ultimo_ticket_durable;
+    unsigned long long _grupos_confirmados;
+
+    /** Si alguna escritura falló, ninguna transacción posterior es durable. */
+    bool _fallo_escritura;
+    bool _detener;
+
+    mutex _mutex;
+    condition_variable _hay_pendientes;
+    condition_variable _grupo_confirmado;
+
+    thread _escritor;
+
+    /** Métodos auxiliares */
+
+    void _escribir_grupos();
+
+    bool _escribir_y_sincronizar(const vector<char>& datos);
+};
+
+#endif
@@ -0,0 +1,215 @@
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "replica_saldos.h"
+
+using namespace std;
+
+namespace {
+
+const uint32_t MAGIA = 0x54443353; // "TD3S"
+const uint32_t VERSION = 2;
+
+// La región es compartida entre procesos, así que los campos tienen que ser
+// atómicos sin locks (no pueden depender de un mutex del proceso).
+static_assert(atomic<uint32_t>::is_always_lock_free, "se necesitan atómicos de 32 bits sin locks");
+static_assert(atomic<uint64_t>::is_always_lock_free, "se necesitan atómicos de 64 bits sin locks");
+
+struct Cabecera {
+  uint32_t magia;
+  uint32_t version;
+  uint64_t capacidad; // cantidad de entradas, potencia de 2
+  atomic<uint64_t> descartadas; // publicaciones rechazadas por tabla llena
+};
+
+struct EntradaCompartida {
+  atomic<uint32_t> id; // 0 = libre (el id 0 no es una billetera)
+  atomic<uint32_t> secuencia; // par = estable, impar = escribiendo, 0 = sin publicar
+  atomic<uint32_t> saldo;
+  atomic<uint32_t> ultima_transaccion;
+  atomic<uint32_t> cantidad_transacciones;
+};
+
+size_t tamano_region(uint64_t capacidad) {
+  return sizeof(Cabecera) + capacidad * sizeof(EntradaCompartida);
+}
+
+EntradaCompartida* entradas(void* region) {
+  return reinterpret_cast<EntradaCompartida*>(static_cast<char*>(region) + sizeof(Cabecera));
+}
+
+uint64_t posicion_inicial(id_billetera id, uint64_t capacidad) {
+  // Hash multiplicativo: los ids son consecutivos y queremos esparcirlos.
+  return (static_cast<uint64_t>(id) * 2654435761u) & (capacidad - 1);
+}
+
+}
+
+ReplicaSaldos::ReplicaSaldos(const string& nombre, size_t capacidad)
+  : _nombre(nombre) {
+  // Dejamos la tabla a lo sumo llena a la mitad para que los sondeos sean
+  // cortos.
+  uint64_t entradas_tabla = 1;
+  while (entradas_tabla < 2 * capacidad) {
+    entradas_tabla *= 2;
+  }
+  _tamano_region = tamano_region(entradas_tabla);
+
+  shm_unlink(nombre.c_str());
+  int descriptor = shm_open(nombre.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (descriptor < 0) {
+    throw runtime_error("no se pudo crear la memoria compartida: " + nombre);
+  }
+  if (ftruncate(descriptor, _tamano_region) != 0) {
+    close(descriptor);
+    shm_unlink(nombre.c_str());
+    throw runtime_error("no se pudo dimensionar la memoria compartida: " + nombre);
+  }
+
+  _region = mmap(nullptr, _tamano_region, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+  close(descriptor);
+  if (_region == MAP_FAILED) {
+    shm_unlink(nombre.c_str());
+    throw runtime_error("no se pudo mapear la memoria compartida: " + nombre);
+  }
+
+  // ftruncate deja la región en 0, que es el estado inicial de todas las
+  // entradas. Escribimos la cabecera al final para que un lector no vea una
+  // tabla a medio inicializar.
+  Cabecera* cabecera = static_cast<Cabecera*>(_region);
+  cabecera->capacidad = entradas_tabla;
+  cabecera->version = VERSION;
+  atomic_thread_fence(memory_order_release);
+  cabecera->magia = MAGIA;
+}
+
+bool ReplicaSaldos::publicar(id_billetera id, monto saldo, timestamp ultima_transaccion, unsigned cantidad_transacciones) {
+  uint64_t capacidad = static_cast<Cabecera*>(_region)->capacidad;
+  EntradaCompartida* tabla = entradas(_region);
+
+  uint64_t posicion = posicion_inicial(id, capacidad);
+  for (uint64_t intentos = 0; intentos < capacidad; intentos++) {
+    EntradaCompartida& entrada = tabla[posicion];
+
+    uint32_t actual = entrada.id.load(memory_order_acquire);
+    if (actual == 0) {
+      // Reservamos la entrada. Si otro hilo la ganó, seguimos comparando con
+      // el id que quedó.
+      entrada.id.compare_exchange_strong(actual, id, memory_order_acq_rel);
+      if (actual == 0) {
+        actual = id;
+      }
+    }
+
+    if (actual == id) {
+      uint32_t secuencia = entrada.secuencia.load(memory_order_relaxed);
+      entrada.secuencia.store(secuencia + 1, memory_order_relaxed);
+      atomic_thread_fence(memory_order_release);
+
+      entrada.saldo.store(saldo, memory_order_relaxed);
+      entrada.ultima_transaccion.store(ultima_transaccion, memory_order_relaxed);
+      entrada.cantidad_transacciones.store(cantidad_transacciones, memory_order_relaxed);
+
+      entrada.secuencia.store(secuencia + 2, memory_order_release);
+      return true;
+    }
+
+    posicion = (posicion + 1) & (capacidad - 1);
+  }
+
+  static_cast<Cabecera*>(_region)->descartadas.fetch_add(1, memory_order_relaxed);
+  return false;
+}
+
+unsigned long long ReplicaSaldos::descartadas() const {
+  return static_cast<const Cabecera*>(_region)->descartadas.load(memory_order_relaxed);
+}
+
+ReplicaSaldos::~ReplicaSaldos() {
+  munmap(_region, _tamano_region);
+  shm_unlink(_nombre.c_str());
+}
+
+LectorReplicaSaldos::LectorReplicaSaldos(const string& nombre) {
+  int descriptor = shm_open(nombre.c_str(), O_RDONLY, 0);
+  if (descriptor < 0) {
+    throw runtime_error("no existe la memoria compartida: " + nombre);
+  }
+
+  struct stat estado;
+  if (fstat(descriptor, &estado) != 0 || static_cast<size_t>(estado.st_size) < sizeof(Cabecera)) {
+    close(descriptor);
+    throw runtime_error("memoria compartida inválida: " + nombre);
+  }
+  _tamano_region = estado.st_size;
+
+  void* region = mmap(nullptr, _tamano_region, PROT_READ, MAP_SHARED, descriptor, 0);
+  close(descriptor);
+  if (region == MAP_FAILED) {
+    throw runtime_error("no se pudo mapear la memoria compartida: " + nombre);
+  }
+  _region = region;
+
+  const Cabecera* cabecera = static_cast<const Cabecera*>(_region);
+  bool valida = cabecera->magia == MAGIA && cabecera->version == VERSION && tamano_region(cabecera->capacidad) <= _tamano_region;
+  atomic_thread_fence(memory_order_acquire);
+  if (!valida) {
+    munmap(region, _tamano_region);
+    throw runtime_error("memoria compartida con formato inesperado: " + nombre);
+  }
+}
+
+bool LectorReplicaSaldos::consultar(id_billetera id, Entrada& entrada) const {
+  uint64_t capacidad = static_cast<const Cabecera*>(_region)->capacidad;
+  // La región está mapeada en solo lectura: sólo hacemos loads.
+  EntradaCompartida* tabla = entradas(const_cast<void*>(_region));
+
+  uint64_t posicion = posicion_inicial(id, capacidad);
+  for (uint64_t intentos = 0; intentos < capacidad; intentos++) {
+    EntradaCompartida& compartida = tabla[posicion];
+
+    uint32_t actual = compartida.id.load(memory_order_acquire);
+    if (actual == 0) {
+      return false;
+    }
+
+    if (actual == id) {
+      while (true) {
+        uint32_t antes = compartida.secuencia.load(memory_order_acquire);
+        if (antes == 0) {
+          return false; // reservada pero todavía sin publicar
+        }
+        if (antes % 2 == 1) {
+          continue; // el escritor está a mitad de camino
+        }
+
+        entrada.saldo = compartida.saldo.load(memory_order_relaxed);
+        entrada.ultima_transaccion = compartida.ultima_transaccion.load(memory_order_relaxed);
+        entrada.cantidad_transacciones = compartida.cantidad_transacciones.load(memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (compartida.secuencia.load(memory_order_relaxed) == antes) {
+          return true;
+        }
+      }
+    }
+
+    posicion = (posicion + 1) & (capacidad - 1);
+  }
+
+  return false;
+}
+
+unsigned long long LectorReplicaSaldos::descartadas() const {
+  return static_cast<const Cabecera*>(_region)->descartadas.load(memory_order_relaxed);
+}
+
+LectorReplicaSaldos::~LectorReplicaSaldos() {
+  munmap(const_cast<void*>(_region), _tamano_region);
+}
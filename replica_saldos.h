@@ -0,0 +1,112 @@
+#ifndef REPLICA_SALDOS_H
+#define REPLICA_SALDOS_H
+
+#include <string>
+
+#include "lib.h"
+
+using namespace std;
+
+/**
+ * Réplica de solo lectura de los saldos de las billeteras, publicada en
+ * memoria compartida (POSIX `shm_open` + `mmap`) para que otros procesos del
+ * mismo host puedan consultarlos sin pasar por la blockchain.
+ *
+ * La región tiene una cabecera y una tabla de hash de tamaño fijo con
+ * direccionamiento abierto (sondeo lineal), indexada por id de billetera.
+ * Cada entrada guarda saldo, timestamp de la última transacción y cantidad
+ * de transacciones, protegidos por un seqlock propio: el escritor incrementa
+ * la secuencia antes y después de escribir, y el lector reintenta si la
+ * secuencia era impar o cambió mientras leía. Consultar no hace syscalls ni
+ * copias fuera de la propia entrada.
+ *
+ * Cada entrada tiene un único escritor (el hilo que impacta las transacciones
+ * de esa billetera). Reservar una entrada nueva se hace con compare-and-swap,
+ * así que varios hilos pueden publicar billeteras distintas a la vez.
+ */
+class ReplicaSaldos {
+  public:
+    /**
+     * Crea (o reemplaza) la región de memoria compartida `nombre` (por
+     * ejemplo "/saldos"), con lugar para `capacidad` billeteras. Lanza
+     * `runtime_error` si no se pudo crear.
+     */
+    ReplicaSaldos(const string& nombre, size_t capacidad);
+
+    /**
+     * Publica el estado actual de una billetera. Devuelve `false` si la
+     * billetera no estaba publicada y la tabla está llena.
+     *
+     * Complejidad: O(1) esperado.
+     */
+    bool publicar(id_billetera id, monto saldo, timestamp ultima_transaccion, unsigned cantidad_transacciones);
+
+    /**
+     * Cantidad de publicaciones rechazadas por tabla llena. Mientras sea 0,
+     * una billetera que no está en la réplica no tuvo ninguna transacción
+     * publicada.
+     */
+    unsigned long long descartadas() const;
+
+    /**
+     * Destructor. Desmapea y elimina la región; los lectores que ya la tenían
+     * mapeada pueden seguir leyendo el último estado publicado.
+     */
+    ~ReplicaSaldos();
+
+    /** Es dueña del mapeo: no se copia. */
+    ReplicaSaldos(const ReplicaSaldos&) = delete;
+    ReplicaSaldos& operator=(const ReplicaSaldos&) = delete;
+
+  private:
+    const string _nombre;
+    void* _region;
+    size_t _tamano_region;
+};
+
+/**
+ * Lector de una réplica publicada por otro proceso (o por el mismo).
+ */
+class LectorReplicaSaldos {
+  public:
+    /** Estado publicado de una billetera. */
+    struct Entrada {
+      monto saldo;
+      timestamp ultima_transaccion;
+      unsigned cantidad_transacciones;
+    };
+
+    /**
+     * Mapea la región `nombre` en modo lectura. Lanza `runtime_error` si no
+     * existe o no tiene el formato esperado.
+     */
+    explicit LectorReplicaSaldos(const string& nombre);
+
+    /**
+     * Busca la billetera `id`. Devuelve `true` y completa `entrada` con una
+     * lectura consistente si está publicada.
+     *
+     * Complejidad: O(1) esperado.
+     */
+    bool consultar(id_billetera id, Entrada& entrada) const;
+
+    /**
+     * Publicaciones que el escritor rechazó por tabla llena (ver
+     * `ReplicaSaldos::descartadas`). Si es mayor a 0, que `consultar` no
+     * encuentre una billetera no implica que no tenga transacciones.
+     */
+    unsigned long long descartadas() const;
+
+    /** Destructor. Desmapea la región. */
+    ~LectorReplicaSaldos();
+
+    /** Es dueño del mapeo: no se copia. */
+    LectorReplicaSaldos(const LectorReplicaSaldos&) = delete;
+    LectorReplicaSaldos& operator=(const LectorReplicaSaldos&) = delete;
+
+  private:
+    const void* _region;
+    size_t _tamano_region;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../arbol_fenwick.h"
+
+using namespace std;
+
+TEST(tests_arbol_fenwick,calcula_sumas_de_prefijos) {
+  ArbolFenwick arbol;
+  arbol.extender(5);
+
+  arbol.sumar(0, 100);
+  arbol.sumar(3, -10);
+  arbol.sumar(1, 5);
+
+  EXPECT_EQ(arbol.tamano(), 5);
+  EXPECT_EQ(arbol.prefijo(0), 100);
+  EXPECT_EQ(arbol.prefijo(1), 105);
+  EXPECT_EQ(arbol.prefijo(2), 105);
+  EXPECT_EQ(arbol.prefijo(4), 95);
+}
+
+TEST(tests_arbol_fenwick,al_extenderse_conserva_las_sumas) {
+  ArbolFenwick arbol;
+  vector<double> valores;
+
+  // Crece de a saltos de tamaño variable y compara contra sumas ingenuas.
+  for (size_t tamano = 1; tamano <= 300; tamano += 1 + tamano % 7) {
+    arbol.extender(tamano);
+    valores.resize(tamano, 0);
+
+    arbol.sumar(tamano - 1, static_cast<double>(tamano));
+    valores[tamano - 1] += tamano;
+    arbol.sumar(tamano / 2, 1);
+    valores[tamano / 2] += 1;
+
+    double esperado = 0;
+    for (size_t i = 0; i < tamano; i++) {
+      esperado += valores[i];
+      ASSERT_EQ(arbol.prefijo(i), esperado);
+    }
+  }
+}
+
+TEST(tests_arbol_fenwick,se_construye_a_partir_de_valores) {
+  vector<double> valores = {3, 0, -1, 4, 0, 0, 2, 5, 1};
+  ArbolFenwick arbol(valores);
+
+  EXPECT_EQ(arbol.tamano(), valores.size());
+  double esperado = 0;
+  for (size_t i = 0; i < valores.size(); i++) {
+    esperado += valores[i];
+    EXPECT_EQ(arbol.prefijo(i), esperado);
+  }
+}
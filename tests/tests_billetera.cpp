@@ -228,3 +228,191 @@ TEST_F(test_billetera, destinatarios_mas_frecuentes_solo_cuenta_transacciones_sa
     { billetera2->id(), billetera3->id() }
   );
 }
+
+TEST_F(test_billetera, admite_transacciones_fuera_de_orden) {
+  Blockchain blockchain;
+  Calendario::fijar(0);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  agregar_transaccion(blockchain, billetera1, billetera2, 10);
+
+  Calendario::avanzar_un_dia();
+  Calendario::avanzar_un_dia();
+  Calendario::avanzar_un_dia();
+  agregar_transaccion(blockchain, billetera1, billetera2, 20);
+
+  // Llega tarde una transacción del día 1.
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera2, billetera1->id(), 5, Calendario::dia(1) + 60));
+
+  EXPECT_EQ(billetera1->saldo(), 75);
+  EXPECT_EQ(billetera2->saldo(), 125);
+
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(0)), 90);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(1)), 95);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(2)), 95);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(3)), 75);
+
+  EXPECT_EQ(billetera2->saldo_al_fin_del_dia(Calendario::dia(0)), 110);
+  EXPECT_EQ(billetera2->saldo_al_fin_del_dia(Calendario::dia(2)), 105);
+  EXPECT_EQ(billetera2->saldo_al_fin_del_dia(Calendario::dia(3)), 125);
+
+  // Se listan en orden de llegada.
+  chequear_transaccion(billetera1->ultimas_transacciones(1)[0], billetera2->id(), billetera1->id(), 5);
+}
+
+TEST_F(test_billetera, permite_consultar_los_destinatarios_mas_frecuentes_en_una_ventana) {
+  Blockchain blockchain;
+  Calendario::fijar(0);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Billetera* billetera3 = blockchain.abrir_billetera();
+  Billetera* billetera4 = blockchain.abrir_billetera();
+
+  // Día 0: 3 transacciones a billetera2
+  for(int i = 0; i < 3; i++) {
+    agregar_transaccion(blockchain, billetera1, billetera2, 1);
+  }
+
+  // Día 5: 2 transacciones a billetera3, 1 a billetera4
+  for(int i = 0; i < 5; i++) {
+    Calendario::avanzar_un_dia();
+  }
+  agregar_transaccion(blockchain, billetera1, billetera3, 1);
+  agregar_transaccion(blockchain, billetera1, billetera3, 1);
+  agregar_transaccion(blockchain, billetera1, billetera4, 1);
+
+  chequear_ids_billeteras(
+    billetera1->destinatarios_mas_frecuentes_en_ventana(3),
+    { billetera2->id(), billetera3->id(), billetera4->id() }
+  );
+
+  // Día 7: la ventana de 7 días cubre los días 1 a 7, así que vencen las del día 0.
+  Calendario::avanzar_un_dia();
+  Calendario::avanzar_un_dia();
+  chequear_ids_billeteras(
+    billetera1->destinatarios_mas_frecuentes_en_ventana(3),
+    { billetera3->id(), billetera4->id() }
+  );
+
+  // La cuenta de toda la vida no cambia.
+  chequear_ids_billeteras(billetera1->detinatarios_mas_frecuentes(1), { billetera2->id() });
+
+  // Con una ventana de 30 días vuelven a contar.
+  billetera1->fijar_ventana_destinatarios(30);
+  chequear_ids_billeteras(
+    billetera1->destinatarios_mas_frecuentes_en_ventana(1),
+    { billetera2->id() }
+  );
+
+  // Con una ventana de 1 día sólo cuenta el día 7, en el que no hubo envíos.
+  billetera1->fijar_ventana_destinatarios(1);
+  EXPECT_TRUE(billetera1->destinatarios_mas_frecuentes_en_ventana(3).empty());
+}
+
+TEST_F(test_billetera, con_indices_perezosos_los_arma_en_la_primera_consulta) {
+  Blockchain blockchain;
+  blockchain.fijar_indices_perezosos(true);
+  Calendario::fijar(Calendario::dia(10));
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Billetera* billetera3 = blockchain.abrir_billetera();
+
+  agregar_transaccion(blockchain, billetera1, billetera2, 10);
+  Calendario::avanzar_un_dia();
+  agregar_transaccion(blockchain, billetera1, billetera3, 5);
+  agregar_transaccion(blockchain, billetera1, billetera3, 5);
+
+  // Sólo se mantienen el saldo y el historial.
+  EXPECT_FALSE(billetera1->indices_materializados());
+  EXPECT_EQ(billetera1->saldo(), 80);
+  EXPECT_EQ(billetera1->ultimas_transacciones(5).size(), 4);
+
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(10)), 90);
+  EXPECT_TRUE(billetera1->indices_materializados());
+  EXPECT_FALSE(billetera2->indices_materializados());
+
+  // A partir de la consulta se mantienen con cada transacción.
+  Calendario::avanzar_un_dia();
+  agregar_transaccion(blockchain, billetera1, billetera2, 1);
+  agregar_transaccion(blockchain, billetera1, billetera2, 1);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(11)), 80);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(12)), 78);
+  chequear_ids_billeteras(billetera1->detinatarios_mas_frecuentes(2), { billetera2->id(), billetera3->id() });
+  chequear_ids_billeteras(billetera1->destinatarios_mas_frecuentes_en_ventana(1), { billetera2->id() });
+}
+
+TEST_F(test_billetera, el_saldo_por_dia_trunca_los_montos_fraccionarios_como_el_saldo) {
+  for (bool perezosos : {false, true}) {
+    Blockchain blockchain;
+    blockchain.fijar_indices_perezosos(perezosos);
+    Calendario::fijar(Calendario::dia(10));
+
+    Billetera* billetera1 = blockchain.abrir_billetera();
+    Billetera* billetera2 = blockchain.abrir_billetera();
+
+    // Cada envío de 0.5 trunca el saldo de billetera1 a un entero menos, y
+    // cada recepción deja a billetera2 igual.
+    EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 0.5));
+    EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 0.5));
+    Calendario::avanzar_un_dia();
+    EXPECT_TRUE(blockchain.agregar_transaccion(billetera2, billetera1->id(), 2.5));
+
+    EXPECT_EQ(billetera1->saldo(), 100);
+    EXPECT_EQ(billetera2->saldo(), 97);
+    EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(10)), 98);
+    EXPECT_EQ(billetera2->saldo_al_fin_del_dia(Calendario::dia(10)), 100);
+    EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::tiempo_actual()), billetera1->saldo());
+    EXPECT_EQ(billetera2->saldo_al_fin_del_dia(Calendario::tiempo_actual()), billetera2->saldo());
+    EXPECT_TRUE(billetera1->indices_materializados());
+
+    // Una vez armados, los índices siguen el mismo truncado.
+    EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 0.5));
+    EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::tiempo_actual()), billetera1->saldo());
+    EXPECT_EQ(billetera2->saldo_al_fin_del_dia(Calendario::tiempo_actual()), billetera2->saldo());
+  }
+}
+
+TEST_F(test_billetera, libera_los_indices_de_billeteras_inactivas) {
+  Blockchain blockchain;
+  Calendario::fijar(Calendario::dia(10));
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  agregar_transaccion(blockchain, billetera1, billetera2, 10);
+
+  // Sin índices perezosos se arman desde la apertura.
+  EXPECT_TRUE(billetera1->indices_materializados());
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(10)), 90);
+
+  Calendario::avanzar_un_dia();
+  EXPECT_EQ(blockchain.liberar_indices_inactivos(Calendario::tiempo_actual()), 2);
+  EXPECT_FALSE(billetera1->indices_materializados());
+  EXPECT_FALSE(billetera2->indices_materializados());
+
+  // Las transacciones siguen impactando en el saldo y el historial.
+  billetera1->fijar_ventana_destinatarios(1);
+  agregar_transaccion(blockchain, billetera1, billetera2, 20);
+  EXPECT_EQ(billetera1->saldo(), 70);
+  EXPECT_EQ(billetera1->cantidad_transacciones(), 3);
+
+  // Se reconstruyen a partir del historial, con el largo de ventana fijado.
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(10)), 90);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(11)), 70);
+  chequear_ids_billeteras(billetera1->detinatarios_mas_frecuentes(1), { billetera2->id() });
+  Calendario::avanzar_un_dia();
+  chequear_ids_billeteras(billetera1->destinatarios_mas_frecuentes_en_ventana(1), {});
+
+  // Sin índices perezosos no se registran las consultas, así que se libera.
+  EXPECT_EQ(blockchain.liberar_indices_inactivos(Calendario::tiempo_actual()), 1);
+  EXPECT_EQ(billetera1->ultima_consulta(), 0);
+
+  // Con índices perezosos, una billetera consultada recién no se libera.
+  blockchain.fijar_indices_perezosos(true);
+  EXPECT_EQ(billetera1->saldo_al_fin_del_dia(Calendario::dia(11)), 70);
+  EXPECT_EQ(billetera1->ultima_consulta(), Calendario::tiempo_actual());
+  EXPECT_EQ(blockchain.liberar_indices_inactivos(Calendario::tiempo_actual()), 0);
+}
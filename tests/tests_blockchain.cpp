@@ -2,6 +2,7 @@
 #include <cassert>
 #include <gtest/gtest.h>
 
+#include "../calendario.h"
 #include "../lib.h"
 #include "../blockchain.h"
 #include "../billetera.h"
@@ -105,3 +106,213 @@ TEST(tests_blockchain,no_permite_hacerse_transferencias_a_uno_mismo) {
   EXPECT_EQ(resultado, false);
   EXPECT_EQ(blockchain.transacciones().size(), 1); // sólo transacción semilla
 }
+
+class test_carga_masiva : public ::testing::Test {
+protected:
+    void SetUp() override    { Calendario::restaurar(); }
+    void TearDown() override { Calendario::restaurar(); }
+};
+
+// Verifica que la billetera cargada responda igual que la original.
+void chequear_billetera_cargada(const Billetera* original, const Billetera* cargada, unsigned dias) {
+  ASSERT_NE(cargada, nullptr);
+  EXPECT_EQ(cargada->saldo(), original->saldo());
+  EXPECT_EQ(cargada->cantidad_transacciones(), original->cantidad_transacciones());
+
+  vector<Transaccion> esperadas = original->ultimas_transacciones(original->cantidad_transacciones());
+  vector<Transaccion> obtenidas = cargada->ultimas_transacciones(original->cantidad_transacciones());
+  ASSERT_EQ(obtenidas.size(), esperadas.size());
+  for (size_t i = 0; i < esperadas.size(); i++) {
+    chequear_transaccion(obtenidas[i], esperadas[i].origen, esperadas[i].destino, esperadas[i].monto);
+    EXPECT_EQ(obtenidas[i]._timestamp, esperadas[i]._timestamp);
+  }
+
+  for (unsigned d = 0; d <= dias; d++) {
+    EXPECT_EQ(cargada->saldo_al_fin_del_dia(Calendario::dia(d)), original->saldo_al_fin_del_dia(Calendario::dia(d)));
+  }
+
+  EXPECT_EQ(cargada->detinatarios_mas_frecuentes(10), original->detinatarios_mas_frecuentes(10));
+  EXPECT_EQ(cargada->destinatarios_mas_frecuentes_en_ventana(10), original->destinatarios_mas_frecuentes_en_ventana(10));
+}
+
+TEST_F(test_carga_masiva, carga_las_billeteras_de_un_listado) {
+  Blockchain original;
+  Calendario::fijar(Calendario::dia(1));
+
+  vector<Billetera*> billeteras;
+  for (int i = 0; i < 6; i++) {
+    billeteras.push_back(original.abrir_billetera());
+    Calendario::avanzar_un_minuto();
+  }
+
+  // Cada billetera le transfiere j + 1 veces a la billetera j, repartidas en
+  // varios días, para que los destinatarios más frecuentes no empaten.
+  for (size_t i = 0; i < billeteras.size(); i++) {
+    for (size_t j = 0; j < billeteras.size(); j++) {
+      for (size_t n = 0; i != j && n <= j; n++) {
+        agregar_transaccion(original, billeteras[i], billeteras[j], 1);
+        Calendario::avanzar_un_dia();
+      }
+    }
+  }
+  // Una transacción que llega fuera de orden.
+  EXPECT_TRUE(original.agregar_transaccion(billeteras[0], billeteras[5]->id(), 3, Calendario::dia(2)));
+
+  vector<Transaccion> listado(original.transacciones().begin(), original.transacciones().end());
+  Blockchain cargada(listado, 3);
+
+  EXPECT_EQ(cargada.transacciones().size(), listado.size());
+  unsigned dias = Calendario::dias_entre(0, Calendario::tiempo_actual());
+  for (Billetera* billetera : billeteras) {
+    chequear_billetera_cargada(billetera, cargada.billetera(billetera->id()), dias);
+  }
+
+  // Con índices perezosos, cada billetera los arma recién al consultarla.
+  Blockchain perezosa(listado, 3, true);
+  EXPECT_TRUE(perezosa.indices_perezosos());
+  for (Billetera* billetera : billeteras) {
+    EXPECT_FALSE(perezosa.billetera(billetera->id())->indices_materializados());
+    chequear_billetera_cargada(billetera, perezosa.billetera(billetera->id()), dias);
+    EXPECT_TRUE(perezosa.billetera(billetera->id())->indices_materializados());
+  }
+}
+
+TEST_F(test_carga_masiva, permite_seguir_operando_luego_de_cargar) {
+  Blockchain original;
+  Billetera* billetera1 = original.abrir_billetera();
+  Billetera* billetera2 = original.abrir_billetera();
+  agregar_transaccion(original, billetera1, billetera2, 30);
+
+  vector<Transaccion> listado(original.transacciones().begin(), original.transacciones().end());
+  Blockchain cargada(listado);
+
+  Billetera* cargada1 = cargada.billetera(billetera1->id());
+  Billetera* cargada2 = cargada.billetera(billetera2->id());
+  EXPECT_EQ(cargada.billetera(0), nullptr);
+
+  Billetera* nueva = cargada.abrir_billetera();
+  EXPECT_GT(nueva->id(), max(billetera1->id(), billetera2->id()));
+
+  agregar_transaccion(cargada, cargada2, nueva, 120);
+  EXPECT_FALSE(cargada.agregar_transaccion(cargada1, nueva->id(), 71));
+
+  EXPECT_EQ(cargada1->saldo(), 70);
+  EXPECT_EQ(cargada2->saldo(), 10);
+  EXPECT_EQ(nueva->saldo(), 220);
+  EXPECT_EQ(cargada.calcular_saldo(cargada2), 10);
+}
+
+TEST_F(test_carga_masiva, carga_un_listado_vacio) {
+  Blockchain cargada(vector<Transaccion>{});
+
+  EXPECT_TRUE(cargada.transacciones().empty());
+  EXPECT_NE(cargada.abrir_billetera(), nullptr);
+}
+
+class test_consultas_por_lote : public ::testing::Test {
+protected:
+    void SetUp() override    { Calendario::restaurar(); }
+    void TearDown() override { Calendario::restaurar(); }
+};
+
+TEST_F(test_consultas_por_lote, permite_consultar_saldos_por_lote) {
+  Blockchain blockchain;
+  Calendario::fijar(Calendario::dia(3));
+
+  // Más billeteras que la distancia de anticipación, para recorrer todas las
+  // etapas.
+  vector<Billetera*> billeteras;
+  vector<id_billetera> ids;
+  for (int i = 0; i < 40; i++) {
+    billeteras.push_back(blockchain.abrir_billetera());
+    ids.push_back(billeteras.back()->id());
+  }
+  Calendario::avanzar_un_dia();
+  for (size_t i = 1; i < billeteras.size(); i++) {
+    agregar_transaccion(blockchain, billeteras[i], billeteras[i - 1], static_cast<monto>(i));
+  }
+  ids.push_back(0);
+
+  vector<monto> saldos;
+  EXPECT_FALSE(blockchain.saldos(ids, saldos));
+  ASSERT_EQ(saldos.size(), ids.size());
+  for (size_t i = 0; i < billeteras.size(); i++) {
+    EXPECT_EQ(saldos[i], billeteras[i]->saldo());
+  }
+  EXPECT_EQ(saldos.back(), 0);
+
+  ids.pop_back();
+  vector<timestamp> momentos;
+  for (size_t i = 0; i < ids.size(); i++) {
+    momentos.push_back(Calendario::dia(3 + i % 2));
+  }
+  EXPECT_TRUE(blockchain.saldos_al_fin_del_dia(ids, momentos, saldos));
+  for (size_t i = 0; i < billeteras.size(); i++) {
+    EXPECT_EQ(saldos[i], billeteras[i]->saldo_al_fin_del_dia(momentos[i]));
+  }
+
+  EXPECT_TRUE(blockchain.saldos_al_fin_del_dia(ids, Calendario::dia(3), saldos));
+  for (size_t i = 0; i < billeteras.size(); i++) {
+    EXPECT_EQ(saldos[i], 100);
+  }
+}
+
+class test_memoria : public ::testing::Test {
+protected:
+    void SetUp() override    { Calendario::restaurar(); }
+    void TearDown() override { Calendario::restaurar(); }
+};
+
+TEST_F(test_memoria, reporta_la_memoria_por_estructura) {
+  Blockchain blockchain;
+  Calendario::fijar(Calendario::dia(1));
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Billetera* billetera3 = blockchain.abrir_billetera();
+
+  Blockchain::ReporteMemoria inicial = blockchain.memoria();
+
+  // billetera1 es la más activa y la que más días tiene en su árbol.
+  for (int i = 0; i < 50; i++) {
+    agregar_transaccion(blockchain, billetera1, i % 2 ? billetera2 : billetera3, 1);
+    Calendario::avanzar_un_dia();
+  }
+  agregar_transaccion(blockchain, billetera2, billetera3, 1);
+
+  Blockchain::ReporteMemoria reporte = blockchain.memoria(2);
+  EXPECT_GT(reporte.transacciones, inicial.transacciones);
+  EXPECT_GT(reporte.billeteras.historial, inicial.billeteras.historial);
+  EXPECT_GT(reporte.billeteras.saldo_por_dia, inicial.billeteras.saldo_por_dia);
+  EXPECT_GT(reporte.billeteras.destinatarios, 0);
+  EXPECT_GT(reporte.registro_billeteras, 0);
+  EXPECT_EQ(reporte.billeteras.objeto, 3 * sizeof(Billetera));
+
+  MemoriaBilletera suma;
+  for (Billetera* billetera : {billetera1, billetera2, billetera3}) {
+    suma += billetera->memoria();
+  }
+  EXPECT_EQ(reporte.billeteras.total(), suma.total());
+  EXPECT_EQ(reporte.total(), reporte.transacciones + reporte.registro_billeteras + suma.total());
+
+  ASSERT_EQ(reporte.mas_pesadas.size(), 2);
+  EXPECT_EQ(reporte.mas_pesadas[0].first, billetera1->id());
+  EXPECT_EQ(reporte.mas_pesadas[0].second.total(), billetera1->memoria().total());
+  EXPECT_GE(reporte.mas_pesadas[0].second.total(), reporte.mas_pesadas[1].second.total());
+
+  // Al liberar los índices sólo quedan el historial y el objeto.
+  blockchain.liberar_indices_inactivos(Calendario::tiempo_actual() + 1);
+  MemoriaBilletera liberada = billetera1->memoria();
+  EXPECT_EQ(liberada.historial, reporte.mas_pesadas[0].second.historial);
+  EXPECT_EQ(liberada.saldo_por_dia, 0);
+  EXPECT_EQ(liberada.destinatarios, 0);
+  EXPECT_EQ(liberada.destinatarios_en_ventana, 0);
+  EXPECT_LT(liberada.total(), reporte.mas_pesadas[0].second.total());
+
+  // Una billetera fría con índices perezosos no paga ni la ventana ni el árbol.
+  blockchain.fijar_indices_perezosos(true);
+  MemoriaBilletera fria = blockchain.abrir_billetera()->memoria();
+  EXPECT_EQ(fria.saldo_por_dia, 0);
+  EXPECT_EQ(fria.destinatarios, 0);
+  EXPECT_EQ(fria.destinatarios_en_ventana, 0);
+}
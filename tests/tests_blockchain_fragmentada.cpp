@@ -0,0 +1,164 @@
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../lib.h"
+#include "../billetera.h"
+#include "../blockchain_fragmentada.h"
+#include "tests_lib.h"
+
+using namespace std;
+
+TEST(tests_blockchain_fragmentada,reparte_las_billeteras_entre_fragmentos) {
+  BlockchainFragmentada blockchain(4);
+
+  vector<bool> fragmento_usado(4, false);
+  for (int i = 0; i < 4; i++) {
+    Billetera* billetera = blockchain.abrir_billetera();
+    fragmento_usado[blockchain.fragmento_de(billetera->id())] = true;
+  }
+
+  EXPECT_EQ(fragmento_usado, vector<bool>(4, true));
+}
+
+TEST(tests_blockchain_fragmentada,permite_transferir_dentro_y_entre_fragmentos) {
+  BlockchainFragmentada blockchain(2);
+
+  // ids consecutivos: billetera1 y billetera3 comparten fragmento.
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Billetera* billetera3 = blockchain.abrir_billetera();
+
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera3->id(), 10)); // mismo fragmento
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 20)); // otro fragmento
+  blockchain.sincronizar();
+
+  EXPECT_EQ(billetera1->saldo(), 70);
+  EXPECT_EQ(billetera2->saldo(), 120);
+  EXPECT_EQ(billetera3->saldo(), 110);
+
+  chequear_transaccion(billetera2->ultimas_transacciones(1)[0], billetera1->id(), billetera2->id(), 20);
+}
+
+TEST(tests_blockchain_fragmentada,valida_las_transacciones) {
+  BlockchainFragmentada blockchain(2);
+  BlockchainFragmentada otra_blockchain(2);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Billetera* ajena = otra_blockchain.abrir_billetera();
+
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 101)); // saldo insuficiente
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billetera1->id(), 1)); // a sí misma
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billetera2->id() + 10, 1)); // destino desconocido
+  EXPECT_FALSE(blockchain.agregar_transaccion(ajena, billetera2->id(), 1)); // origen desconocido
+
+  EXPECT_EQ(blockchain.transacciones().size(), 2); // sólo transacciones semilla
+}
+
+TEST(tests_blockchain_fragmentada,el_origen_nunca_queda_en_negativo) {
+  BlockchainFragmentada blockchain(2);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  vector<future<bool>> resultados;
+  for (int i = 0; i < 30; i++) {
+    resultados.push_back(blockchain.enviar_transaccion(billetera1, billetera2->id(), 7));
+  }
+
+  int aprobadas = 0;
+  for (auto& resultado : resultados) {
+    aprobadas += resultado.get();
+  }
+  blockchain.sincronizar();
+
+  EXPECT_EQ(aprobadas, 14);
+  EXPECT_EQ(billetera1->saldo(), 2);
+  EXPECT_EQ(billetera2->saldo(), 198);
+}
+
+TEST(tests_blockchain_fragmentada,transacciones_devuelve_la_vista_unificada_en_orden) {
+  BlockchainFragmentada blockchain(3);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Billetera* billetera3 = blockchain.abrir_billetera();
+
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1));
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera2, billetera3->id(), 2));
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera3, billetera1->id(), 3));
+
+  list<Transaccion> transacciones = blockchain.transacciones();
+  vector<Transaccion> v(transacciones.begin(), transacciones.end());
+
+  EXPECT_EQ(v.size(), 6);
+  chequear_transaccion(v[0], 0, billetera1->id(), 100);
+  chequear_transaccion(v[1], 0, billetera2->id(), 100);
+  chequear_transaccion(v[2], 0, billetera3->id(), 100);
+  chequear_transaccion(v[3], billetera1->id(), billetera2->id(), 1);
+  chequear_transaccion(v[4], billetera2->id(), billetera3->id(), 2);
+  chequear_transaccion(v[5], billetera3->id(), billetera1->id(), 3);
+}
+
+TEST(tests_blockchain_fragmentada,admite_transacciones_desde_varios_hilos) {
+  BlockchainFragmentada blockchain(4);
+
+  vector<Billetera*> billeteras;
+  for (int i = 0; i < 8; i++) {
+    billeteras.push_back(blockchain.abrir_billetera());
+  }
+
+  vector<thread> hilos;
+  for (int h = 0; h < 4; h++) {
+    hilos.emplace_back([&blockchain, &billeteras, h]() {
+      for (int i = 0; i < 100; i++) {
+        Billetera* origen = billeteras[(h + i) % billeteras.size()];
+        id_billetera destino = billeteras[(h + 3 * i + 1) % billeteras.size()]->id();
+        blockchain.enviar_transaccion(origen, destino, 1);
+      }
+    });
+  }
+  for (auto& hilo : hilos) {
+    hilo.join();
+  }
+  blockchain.sincronizar();
+
+  // El dinero se conserva.
+  monto total = 0;
+  for (Billetera* billetera : billeteras) {
+    total += billetera->saldo();
+  }
+  EXPECT_EQ(total, 800);
+}
+
+TEST(tests_blockchain_fragmentada,reporta_la_memoria_de_todos_los_fragmentos) {
+  BlockchainFragmentada blockchain(2);
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Billetera* billetera3 = blockchain.abrir_billetera();
+
+  for (int i = 0; i < 20; i++) {
+    blockchain.enviar_transaccion(billetera1, billetera3->id(), 1); // mismo fragmento
+  }
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera2, billetera1->id(), 1)); // otro fragmento
+
+  BlockchainFragmentada::ReporteMemoria reporte = blockchain.memoria(2);
+
+  // Una secuencia por transacción de cada fragmento: 3 semillas, 20 locales
+  // y el crédito, que está en los dos fragmentos.
+  EXPECT_GE(reporte.secuencias, 25 * sizeof(unsigned long long));
+  EXPECT_EQ(reporte.fragmentos.billeteras.objeto, 3 * sizeof(Billetera));
+
+  MemoriaBilletera suma;
+  for (Billetera* billetera : {billetera1, billetera2, billetera3}) {
+    suma += billetera->memoria();
+  }
+  EXPECT_EQ(reporte.fragmentos.billeteras.total(), suma.total());
+  EXPECT_EQ(reporte.total(), reporte.fragmentos.total() + reporte.secuencias);
+
+  ASSERT_EQ(reporte.fragmentos.mas_pesadas.size(), 2);
+  EXPECT_EQ(reporte.fragmentos.mas_pesadas[0].first, billetera1->id());
+  EXPECT_GE(reporte.fragmentos.mas_pesadas[0].second.total(), reporte.fragmentos.mas_pesadas[1].second.total());
+}
@@ -0,0 +1,46 @@
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../calendario.h"
+#include "../lib.h"
+#include "../frecuencias_ventana.h"
+
+using namespace std;
+
+TEST(tests_frecuencias_ventana,vence_los_envios_de_a_uno) {
+  FrecuenciasVentana frecuencias(2);
+
+  frecuencias.registrar(1, Calendario::dia(0));
+  frecuencias.registrar(1, Calendario::dia(0));
+  frecuencias.registrar(2, Calendario::dia(1));
+  frecuencias.registrar(1, Calendario::dia(1));
+
+  EXPECT_EQ(frecuencias.mas_frecuentes(2), vector<id_billetera>({1, 2}));
+
+  // En el día 2 vencen los dos envíos a 1 del día 0, y queda empatado con 2.
+  frecuencias.avanzar(Calendario::dia(2));
+  EXPECT_EQ(frecuencias.mas_frecuentes(5).size(), 2);
+
+  frecuencias.registrar(2, Calendario::dia(2));
+  EXPECT_EQ(frecuencias.mas_frecuentes(1), vector<id_billetera>({2}));
+
+  frecuencias.avanzar(Calendario::dia(10));
+  EXPECT_TRUE(frecuencias.mas_frecuentes(5).empty());
+}
+
+TEST(tests_frecuencias_ventana,admite_envios_de_dias_anteriores) {
+  FrecuenciasVentana frecuencias(3);
+
+  frecuencias.registrar(1, Calendario::dia(4));
+  frecuencias.registrar(2, Calendario::dia(2)); // dentro de la ventana (días 2 a 4)
+  frecuencias.registrar(2, Calendario::dia(3));
+  frecuencias.registrar(3, Calendario::dia(1)); // ya vencido, se ignora
+
+  EXPECT_EQ(frecuencias.mas_frecuentes(5), vector<id_billetera>({2, 1}));
+
+  // En el día 5 vence el envío del día 2.
+  frecuencias.avanzar(Calendario::dia(5));
+  EXPECT_EQ(frecuencias.mas_frecuentes(5).size(), 2);
+  frecuencias.avanzar(Calendario::dia(6));
+  EXPECT_EQ(frecuencias.mas_frecuentes(5), vector<id_billetera>({1}));
+}
@@ -0,0 +1,97 @@
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../lib.h"
+#include "../billetera.h"
+#include "../blockchain.h"
+#include "../grafo_transacciones.h"
+#include "tests_lib.h"
+
+using namespace std;
+
+// Billeteras 1, 2, 3 forman un ciclo; 4 -> 5 es una cadena aparte y 6 está
+// aislada (sólo tiene su transacción semilla).
+list<Transaccion> transacciones_de_ejemplo() {
+  return {
+    {0, 1, 100, 0}, {0, 2, 100, 0}, {0, 3, 100, 0}, {0, 4, 100, 0}, {0, 5, 100, 0}, {0, 6, 100, 0},
+    {1, 2, 10, 1}, {1, 2, 5, 2}, {2, 3, 7, 3}, {3, 1, 1, 4}, {4, 5, 50, 5}, {1, 4, 2, 6},
+  };
+}
+
+TEST(tests_grafo_transacciones,agrupa_las_transferencias_repetidas) {
+  GrafoTransacciones grafo(transacciones_de_ejemplo(), 3);
+
+  EXPECT_EQ(grafo.cantidad_vertices(), 6);
+  EXPECT_EQ(grafo.cantidad_aristas(), 5);
+  EXPECT_EQ(grafo.grado_salida(grafo.vertice(1)), 2);
+  EXPECT_EQ(grafo.grado_entrada(grafo.vertice(1)), 1);
+  EXPECT_EQ(grafo.grado_entrada(grafo.vertice(6)), 0);
+  EXPECT_EQ(grafo.vertice(7), grafo.cantidad_vertices());
+
+  vector<GrafoTransacciones::Flujo> flujos = grafo.flujos_mas_pesados(2, 2);
+  EXPECT_EQ(flujos.size(), 2);
+  EXPECT_EQ(flujos[0].origen, 4);
+  EXPECT_EQ(flujos[0].monto, 50);
+  EXPECT_EQ(flujos[1].origen, 1);
+  EXPECT_EQ(flujos[1].destino, 2);
+  EXPECT_EQ(flujos[1].cantidad, 2);
+  EXPECT_EQ(flujos[1].monto, 15);
+}
+
+TEST(tests_grafo_transacciones,permite_recorrer_con_bfs) {
+  GrafoTransacciones grafo(transacciones_de_ejemplo(), 2);
+
+  vector<int> distancias = grafo.bfs(2, 2);
+  EXPECT_EQ(distancias[grafo.vertice(2)], 0);
+  EXPECT_EQ(distancias[grafo.vertice(3)], 1);
+  EXPECT_EQ(distancias[grafo.vertice(1)], 2);
+  EXPECT_EQ(distancias[grafo.vertice(4)], 3);
+  EXPECT_EQ(distancias[grafo.vertice(5)], 4);
+  EXPECT_EQ(distancias[grafo.vertice(6)], -1);
+}
+
+TEST(tests_grafo_transacciones,calcula_componentes) {
+  GrafoTransacciones grafo(transacciones_de_ejemplo(), 4);
+
+  vector<size_t> conexas = grafo.componentes_conexas(4);
+  EXPECT_EQ(conexas, vector<size_t>({0, 0, 0, 0, 0, 5}));
+
+  vector<size_t> fuertes = grafo.componentes_fuertemente_conexas();
+  EXPECT_EQ(fuertes[0], fuertes[1]);
+  EXPECT_EQ(fuertes[1], fuertes[2]);
+  EXPECT_NE(fuertes[3], fuertes[0]);
+  EXPECT_NE(fuertes[3], fuertes[4]);
+}
+
+TEST(tests_grafo_transacciones,ranking_suma_uno_y_premia_a_los_destinatarios) {
+  GrafoTransacciones grafo(transacciones_de_ejemplo(), 2);
+
+  vector<double> ranking = grafo.ranking(30, 0.85, 2);
+  double total = 0;
+  for (double puntaje : ranking) {
+    total += puntaje;
+  }
+
+  EXPECT_NEAR(total, 1, 1e-9);
+  EXPECT_GT(ranking[grafo.vertice(5)], ranking[grafo.vertice(6)]);
+}
+
+TEST(tests_grafo_transacciones,la_blockchain_construye_su_grafo) {
+  Blockchain blockchain;
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Billetera* billetera3 = blockchain.abrir_billetera();
+
+  agregar_transaccion(blockchain, billetera1, billetera2, 10);
+  agregar_transaccion(blockchain, billetera1, billetera3, 10);
+
+  GrafoTransacciones grafo = blockchain.grafo(2);
+  EXPECT_EQ(grafo.cantidad_vertices(), 3);
+  EXPECT_EQ(grafo.cantidad_aristas(), 2);
+
+  map<size_t, size_t> salida = grafo.distribucion_grados_salida(2);
+  EXPECT_EQ(salida, (map<size_t, size_t>{{0, 2}, {2, 1}}));
+  map<size_t, size_t> entrada = grafo.distribucion_grados_entrada(2);
+  EXPECT_EQ(entrada, (map<size_t, size_t>{{0, 1}, {1, 2}}));
+}
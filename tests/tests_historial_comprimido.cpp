@@ -0,0 +1,63 @@
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../lib.h"
+#include "../historial_comprimido.h"
+
+using namespace std;
+
+void chequear_igual(Transaccion a, Transaccion b) {
+  EXPECT_EQ(a.origen, b.origen);
+  EXPECT_EQ(a.destino, b.destino);
+  EXPECT_EQ(a.monto, b.monto);
+  EXPECT_EQ(a._timestamp, b._timestamp);
+}
+
+TEST(tests_historial_comprimido,recupera_las_transacciones_agregadas) {
+  HistorialComprimido historial(1000);
+
+  vector<Transaccion> transacciones = {
+    {0, 1000, 100, 500},            // semilla
+    {1000, 4000000000u, 10, 600},   // contraparte lejana
+    {77, 1000, 2.75, 550},          // monto no entero y timestamp anterior
+    {1000, 77, 1e12, 4000000000u},  // monto que no entra en 32 bits
+  };
+  for (Transaccion t : transacciones) {
+    historial.agregar(t);
+  }
+
+  EXPECT_EQ(historial.cantidad(), 4);
+
+  vector<Transaccion> ultimas = historial.ultimas(10);
+  EXPECT_EQ(ultimas.size(), 4);
+  for (size_t i = 0; i < ultimas.size(); i++) {
+    chequear_igual(ultimas[i], transacciones[transacciones.size() - 1 - i]);
+  }
+
+  size_t i = 0;
+  historial.para_cada([&transacciones, &i](const Transaccion& t) {
+    chequear_igual(t, transacciones[i++]);
+  });
+  EXPECT_EQ(i, 4);
+}
+
+TEST(tests_historial_comprimido,decodifica_a_traves_de_varios_bloques) {
+  HistorialComprimido historial(5);
+
+  vector<Transaccion> transacciones;
+  for (unsigned i = 0; i < 5 * HistorialComprimido::TRANSACCIONES_POR_BLOQUE + 3; i++) {
+    Transaccion t = i % 3 == 0 ? Transaccion{5, 6 + i % 4, static_cast<double>(i), 1000 + 60 * i}
+                               : Transaccion{6 + i % 4, 5, static_cast<double>(i), 1000 + 60 * i};
+    transacciones.push_back(t);
+    historial.agregar(t);
+  }
+
+  vector<Transaccion> ultimas = historial.ultimas(HistorialComprimido::TRANSACCIONES_POR_BLOQUE + 5);
+  EXPECT_EQ(ultimas.size(), HistorialComprimido::TRANSACCIONES_POR_BLOQUE + 5);
+  for (size_t i = 0; i < ultimas.size(); i++) {
+    chequear_igual(ultimas[i], transacciones[transacciones.size() - 1 - i]);
+  }
+
+  // Con contrapartes y timestamps cercanos, cada transacción ocupa pocos bytes.
+  EXPECT_LT(historial.bytes(), 8 * transacciones.size());
+}
@@ -0,0 +1,54 @@
+#include <list>
+#include <map>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../lib.h"
+#include "../memoria.h"
+
+using namespace std;
+
+TEST(tests_memoria, cuenta_los_bytes_pedidos_y_liberados) {
+  size_t bytes = 0;
+  {
+    vector<double, AsignadorContado<double>> v{AsignadorContado<double>(&bytes)};
+    v.reserve(100);
+    EXPECT_EQ(bytes, 100 * sizeof(double));
+
+    v.shrink_to_fit();
+    EXPECT_EQ(bytes, 0);
+  }
+  EXPECT_EQ(bytes, 0);
+}
+
+TEST(tests_memoria, cuenta_los_nodos_de_contenedores_enlazados) {
+  size_t bytes = 0;
+  ListaTransacciones lista{AsignadorContado<Transaccion>(&bytes)};
+
+  lista.push_back({0, 1, 100, 0});
+  size_t por_nodo = bytes;
+  EXPECT_GE(por_nodo, sizeof(Transaccion));
+
+  lista.push_back({1, 2, 10, 0});
+  EXPECT_EQ(bytes, 2 * por_nodo);
+
+  lista.clear();
+  EXPECT_EQ(bytes, 0);
+}
+
+TEST(tests_memoria, los_contenedores_movidos_siguen_contando_en_su_contador) {
+  size_t bytes = 0;
+  vector<int, AsignadorContado<int>> destino{AsignadorContado<int>(&bytes)};
+  {
+    vector<int, AsignadorContado<int>> origen(1000, 0, AsignadorContado<int>(&bytes));
+    destino = std::move(origen);
+  }
+  EXPECT_EQ(bytes, 1000 * sizeof(int));
+
+  // Con otro contador no se puede robar el buffer: se copian los elementos.
+  size_t otros_bytes = 0;
+  vector<int, AsignadorContado<int>> ajeno(500, 0, AsignadorContado<int>(&otros_bytes));
+  destino = std::move(ajeno);
+  EXPECT_EQ(destino.size(), 500);
+  EXPECT_EQ(bytes, destino.capacity() * sizeof(int));
+}
@@ -0,0 +1,175 @@
+#include <string>
+#include <gtest/gtest.h>
+
+#include "../calendario.h"
+#include "../lib.h"
+#include "../blockchain.h"
+#include "../billetera.h"
+#include "../mempool.h"
+#include "tests_lib.h"
+
+using namespace std;
+
+class test_mempool : public ::testing::Test {
+protected:
+    void SetUp() override    { Calendario::restaurar(); }
+    void TearDown() override { Calendario::restaurar(); }
+};
+
+TEST_F(test_mempool, confirma_por_prioridad_y_luego_por_llegada) {
+  Blockchain blockchain;
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Billetera* billetera3 = blockchain.abrir_billetera();
+
+  Mempool mempool(&blockchain);
+  Mempool::id_pendiente baja = mempool.encolar(billetera1, billetera2->id(), 10, 1);
+  Mempool::id_pendiente alta = mempool.encolar(billetera2, billetera3->id(), 20, 5);
+  Mempool::id_pendiente baja_tardia = mempool.encolar(billetera3, billetera1->id(), 30, 1);
+
+  EXPECT_EQ(mempool.cantidad(), 3);
+
+  Mempool::Lote lote = mempool.confirmar(10);
+
+  EXPECT_EQ(lote.confirmadas, vector<Mempool::id_pendiente>({alta, baja, baja_tardia}));
+  EXPECT_TRUE(lote.descartadas.empty());
+  EXPECT_EQ(mempool.cantidad(), 0);
+
+  // Después de las 3 transacciones de saldo inicial.
+  auto it = next(blockchain.transacciones().begin(), 3);
+  chequear_transaccion(*it++, billetera2->id(), billetera3->id(), 20);
+  chequear_transaccion(*it++, billetera1->id(), billetera2->id(), 10);
+  chequear_transaccion(*it++, billetera3->id(), billetera1->id(), 30);
+}
+
+TEST_F(test_mempool, respeta_el_maximo_del_lote) {
+  Blockchain blockchain;
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  Mempool mempool(&blockchain);
+  Mempool::id_pendiente primera = mempool.encolar(billetera1, billetera2->id(), 10, 0);
+  Mempool::id_pendiente segunda = mempool.encolar(billetera1, billetera2->id(), 10, 0);
+
+  EXPECT_EQ(mempool.confirmar(1).confirmadas, vector<Mempool::id_pendiente>({primera}));
+  EXPECT_FALSE(mempool.pendiente(primera));
+  EXPECT_TRUE(mempool.pendiente(segunda));
+
+  EXPECT_EQ(mempool.confirmar(1).confirmadas, vector<Mempool::id_pendiente>({segunda}));
+  EXPECT_EQ(billetera1->saldo(), 80);
+}
+
+TEST_F(test_mempool, reintenta_las_pendientes_que_se_vuelven_validas) {
+  Blockchain blockchain;
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  Billetera* billetera3 = blockchain.abrir_billetera();
+
+  Mempool mempool(&blockchain);
+  // billetera1 tiene 100: la de más prioridad espera a lo que le manda
+  // billetera2, y la siguiente de billetera1 no se le adelanta.
+  Mempool::id_pendiente dependiente = mempool.encolar(billetera1, billetera3->id(), 150, 10);
+  Mempool::id_pendiente siguiente = mempool.encolar(billetera1, billetera3->id(), 5, 10);
+  Mempool::id_pendiente fondeo = mempool.encolar(billetera2, billetera1->id(), 60, 1);
+
+  Mempool::Lote lote = mempool.confirmar(10);
+
+  EXPECT_EQ(lote.confirmadas, vector<Mempool::id_pendiente>({fondeo, dependiente, siguiente}));
+  EXPECT_EQ(billetera1->saldo(), 5);
+  EXPECT_EQ(billetera3->saldo(), 255);
+}
+
+TEST_F(test_mempool, deja_pendientes_las_cadenas_sin_saldo) {
+  Blockchain blockchain;
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  Mempool mempool(&blockchain);
+  Mempool::id_pendiente sin_saldo = mempool.encolar(billetera1, billetera2->id(), 500, 1);
+
+  EXPECT_TRUE(mempool.confirmar(10).confirmadas.empty());
+  EXPECT_TRUE(mempool.pendiente(sin_saldo));
+
+  // Fondos recibidos por fuera del mempool: hay que pedir el reintento.
+  for (int i = 0; i < 4; i++) {
+    Billetera* donante = blockchain.abrir_billetera();
+    agregar_transaccion(blockchain, donante, billetera1, 100);
+  }
+  EXPECT_TRUE(mempool.confirmar(10).confirmadas.empty());
+
+  mempool.reintentar_bloqueadas();
+  EXPECT_EQ(mempool.confirmar(10).confirmadas, vector<Mempool::id_pendiente>({sin_saldo}));
+  EXPECT_EQ(billetera1->saldo(), 0);
+  EXPECT_EQ(billetera2->saldo(), 600);
+}
+
+TEST_F(test_mempool, cancela_y_descarta) {
+  Blockchain blockchain;
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  Mempool mempool(&blockchain);
+  Mempool::id_pendiente cancelada = mempool.encolar(billetera1, billetera2->id(), 10, 5);
+  Mempool::id_pendiente invalida = mempool.encolar(billetera1, billetera1->id(), 10, 3);
+  Mempool::id_pendiente valida = mempool.encolar(billetera1, billetera2->id(), 10, 1);
+
+  EXPECT_TRUE(mempool.cancelar(cancelada));
+  EXPECT_FALSE(mempool.cancelar(cancelada));
+
+  Mempool::Lote lote = mempool.confirmar(10);
+
+  EXPECT_EQ(lote.confirmadas, vector<Mempool::id_pendiente>({valida}));
+  EXPECT_EQ(lote.descartadas, vector<Mempool::id_pendiente>({invalida}));
+  EXPECT_EQ(billetera1->saldo(), 90);
+}
+
+TEST_F(test_mempool, soporta_muchas_pendientes) {
+  Blockchain blockchain;
+  vector<Billetera*> billeteras;
+  for (int i = 0; i < 100; i++) {
+    billeteras.push_back(blockchain.abrir_billetera());
+  }
+
+  Mempool mempool(&blockchain);
+  vector<Mempool::id_pendiente> ids;
+  for (unsigned i = 0; i < 200000; i++) {
+    Billetera* origen = billeteras[i % billeteras.size()];
+    Billetera* destino = billeteras[(i * 7 + 1) % billeteras.size()];
+    ids.push_back(mempool.encolar(origen, destino->id(), 1, i % 1000));
+  }
+  for (size_t i = 0; i < ids.size(); i += 2) {
+    EXPECT_TRUE(mempool.cancelar(ids[i]));
+  }
+  EXPECT_EQ(mempool.cantidad(), 100000);
+
+  // La primera confirmada es la de mayor prioridad que llegó primero.
+  Mempool::Lote lote = mempool.confirmar(1);
+  EXPECT_EQ(lote.confirmadas, vector<Mempool::id_pendiente>({ids[999]}));
+  EXPECT_EQ(mempool.cantidad(), 99999);
+}
+
+TEST_F(test_mempool, bloquea_por_saldo_igual_que_la_blockchain_con_montos_fraccionarios) {
+  Blockchain blockchain;
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  Mempool mempool(&blockchain);
+  Mempool::id_pendiente casi_todo = mempool.encolar(billetera1, billetera2->id(), 99.5, 1);
+  EXPECT_EQ(mempool.confirmar(10).confirmadas, vector<Mempool::id_pendiente>({casi_todo}));
+
+  // El medio que queda se trunca, tanto en la billetera como en la
+  // validación de la blockchain.
+  EXPECT_EQ(billetera1->saldo(), 0);
+  EXPECT_EQ(blockchain.calcular_saldo(billetera1), billetera1->saldo());
+
+  Mempool::id_pendiente fraccion = mempool.encolar(billetera1, billetera2->id(), 0.3, 1);
+  EXPECT_TRUE(mempool.confirmar(10).confirmadas.empty());
+  EXPECT_TRUE(mempool.pendiente(fraccion));
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 0.3));
+
+  // Con un entero recibido alcanza para ambos.
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera2, billetera1->id(), 1));
+  mempool.reintentar_bloqueadas();
+  EXPECT_EQ(mempool.confirmar(10).confirmadas, vector<Mempool::id_pendiente>({fraccion}));
+  EXPECT_EQ(blockchain.calcular_saldo(billetera1), billetera1->saldo());
+}
@@ -0,0 +1,174 @@
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include "../lib.h"
+#include "../billetera.h"
+#include "../blockchain.h"
+#include "../blockchain_fragmentada.h"
+#include "../registro_persistente.h"
+#include "tests_lib.h"
+
+using namespace std;
+
+class test_registro_persistente : public ::testing::Test {
+protected:
+    string ruta;
+
+    void SetUp() override {
+      ruta = "registro_persistente_" + to_string(getpid()) + ".log";
+      remove(ruta.c_str());
+    }
+
+    void TearDown() override { remove(ruta.c_str()); }
+};
+
+TEST_F(test_registro_persistente, permite_leer_lo_escrito) {
+  {
+    RegistroPersistente registro(ruta);
+    unsigned long long ticket1 = registro.agregar({0, 7, 100, 10});
+    unsigned long long ticket2 = registro.agregar({7, 8, 2.5, 20});
+
+    EXPECT_TRUE(registro.esperar(ticket2));
+    EXPECT_TRUE(registro.esperar(ticket1));
+  }
+
+  vector<Transaccion> leidas = RegistroPersistente::leer(ruta);
+  EXPECT_EQ(leidas.size(), 2);
+  chequear_transaccion(leidas[0], 0, 7, 100);
+  EXPECT_EQ(leidas[0]._timestamp, 10);
+  EXPECT_EQ(leidas[1].monto, 2.5);
+  EXPECT_EQ(leidas[1]._timestamp, 20);
+}
+
+TEST_F(test_registro_persistente, agrupa_transacciones_concurrentes) {
+  RegistroPersistente::Configuracion configuracion;
+  configuracion.ventana = chrono::milliseconds(50);
+  RegistroPersistente registro(ruta, configuracion);
+
+  vector<thread> hilos;
+  for (int h = 0; h < 8; h++) {
+    hilos.emplace_back([&registro, h]() {
+      EXPECT_TRUE(registro.esperar(registro.agregar({1, 2, static_cast<double>(h), 0})));
+    });
+  }
+  for (auto& hilo : hilos) {
+    hilo.join();
+  }
+
+  EXPECT_EQ(registro.transacciones_confirmadas(), 8);
+  EXPECT_LT(registro.grupos_confirmados(), 8);
+}
+
+TEST_F(test_registro_persistente, la_blockchain_persiste_sus_transacciones) {
+  RegistroPersistente registro(ruta);
+  Blockchain blockchain;
+  blockchain.persistir_en(&registro);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  agregar_transaccion(blockchain, billetera1, billetera2, 10);
+
+  // Al volver de agregar_transaccion ya es durable.
+  vector<Transaccion> leidas = RegistroPersistente::leer(ruta);
+  EXPECT_EQ(leidas.size(), 3);
+  chequear_transaccion(leidas[2], billetera1->id(), billetera2->id(), 10);
+}
+
+TEST_F(test_registro_persistente, la_blockchain_agrega_sin_esperar_y_espera_la_ultima) {
+  RegistroPersistente::Configuracion configuracion;
+  configuracion.ventana = chrono::milliseconds(50);
+  RegistroPersistente registro(ruta, configuracion);
+  Blockchain blockchain;
+  blockchain.persistir_en(&registro);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  unsigned long long grupos_antes = registro.grupos_confirmados();
+
+  unsigned long long ticket1 = blockchain.agregar_sin_esperar(billetera1, billetera2->id(), 10);
+  unsigned long long ticket2 = blockchain.agregar_sin_esperar(billetera1, billetera2->id(), 20);
+  EXPECT_EQ(blockchain.agregar_sin_esperar(billetera1, billetera2->id(), 1000), 0);
+  EXPECT_EQ(billetera1->saldo(), 70);
+
+  EXPECT_TRUE(blockchain.esperar_durable(ticket2));
+  EXPECT_TRUE(blockchain.esperar_durable(ticket1));
+  EXPECT_FALSE(blockchain.esperar_durable(0));
+  EXPECT_EQ(registro.grupos_confirmados() - grupos_antes, 1);
+  EXPECT_EQ(RegistroPersistente::leer(ruta).size(), 4);
+}
+
+TEST_F(test_registro_persistente, la_blockchain_no_impacta_con_el_registro_fallado) {
+  Blockchain blockchain;
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  // Toda escritura en /dev/full falla con ENOSPC.
+  RegistroPersistente registro("/dev/full");
+  blockchain.persistir_en(&registro);
+
+  // La primera falla al escribirse, cuando ya estaba impactada.
+  unsigned long long ticket = blockchain.agregar_sin_esperar(billetera1, billetera2->id(), 10);
+  EXPECT_NE(ticket, 0);
+  EXPECT_FALSE(blockchain.esperar_durable(ticket));
+  EXPECT_EQ(billetera1->saldo(), 90);
+
+  // Las siguientes se rechazan sin impactarse.
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 10));
+  EXPECT_EQ(billetera1->saldo(), 90);
+  EXPECT_EQ(blockchain.abrir_billetera(), nullptr);
+  EXPECT_EQ(blockchain.transacciones().size(), 3);
+}
+
+TEST_F(test_registro_persistente, la_blockchain_fragmentada_no_abre_billeteras_con_el_registro_fallado) {
+  // Toda escritura en /dev/full falla con ENOSPC.
+  RegistroPersistente registro("/dev/full");
+  BlockchainFragmentada blockchain(2);
+  blockchain.persistir_en(&registro);
+
+  // La semilla de la primera se impacta en su fragmento, pero no es durable.
+  EXPECT_EQ(blockchain.abrir_billetera(), nullptr);
+  EXPECT_TRUE(registro.fallo_escritura());
+  EXPECT_EQ(blockchain.transacciones().size(), 1);
+
+  // Las siguientes se rechazan sin registrarse.
+  EXPECT_EQ(blockchain.abrir_billetera(), nullptr);
+  EXPECT_EQ(blockchain.transacciones().size(), 1);
+}
+
+TEST_F(test_registro_persistente, la_blockchain_fragmentada_persiste_cada_transaccion_una_vez) {
+  RegistroPersistente registro(ruta);
+  BlockchainFragmentada blockchain(2);
+  blockchain.persistir_en(&registro);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 10));
+  EXPECT_FALSE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 1000));
+
+  vector<Transaccion> leidas = RegistroPersistente::leer(ruta);
+  EXPECT_EQ(leidas.size(), 3);
+  chequear_transaccion(leidas[2], billetera1->id(), billetera2->id(), 10);
+}
+
+TEST_F(test_registro_persistente, permite_cargar_una_blockchain_desde_el_registro) {
+  RegistroPersistente registro(ruta);
+  Blockchain original;
+  original.persistir_en(&registro);
+
+  Billetera* billetera1 = original.abrir_billetera();
+  Billetera* billetera2 = original.abrir_billetera();
+  agregar_transaccion(original, billetera1, billetera2, 25);
+  agregar_transaccion(original, billetera2, billetera1, 5);
+
+  Blockchain cargada(ruta);
+
+  EXPECT_EQ(cargada.transacciones().size(), 4);
+  EXPECT_EQ(cargada.billetera(billetera1->id())->saldo(), 80);
+  EXPECT_EQ(cargada.billetera(billetera2->id())->saldo(), 120);
+  EXPECT_EQ(cargada.billetera(billetera2->id())->detinatarios_mas_frecuentes(1), vector<id_billetera>{billetera1->id()});
+}
@@ -0,0 +1,139 @@
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include "../calendario.h"
+#include "../lib.h"
+#include "../billetera.h"
+#include "../blockchain.h"
+#include "../blockchain_fragmentada.h"
+#include "../replica_saldos.h"
+#include "tests_lib.h"
+
+using namespace std;
+
+class test_replica_saldos : public ::testing::Test {
+protected:
+    string nombre;
+
+    void SetUp() override {
+      Calendario::restaurar();
+      nombre = "/td3_saldos_" + to_string(getpid());
+    }
+
+    void TearDown() override { Calendario::restaurar(); }
+};
+
+TEST_F(test_replica_saldos, permite_consultar_lo_publicado) {
+  ReplicaSaldos replica(nombre, 10);
+  LectorReplicaSaldos lector(nombre);
+
+  LectorReplicaSaldos::Entrada entrada;
+  EXPECT_FALSE(lector.consultar(7, entrada));
+
+  EXPECT_TRUE(replica.publicar(7, 100, 50, 1));
+  EXPECT_TRUE(replica.publicar(7, 90, 60, 2));
+
+  EXPECT_TRUE(lector.consultar(7, entrada));
+  EXPECT_EQ(entrada.saldo, 90);
+  EXPECT_EQ(entrada.ultima_transaccion, 60);
+  EXPECT_EQ(entrada.cantidad_transacciones, 2);
+  EXPECT_FALSE(lector.consultar(8, entrada));
+}
+
+TEST_F(test_replica_saldos, no_publica_mas_billeteras_que_su_capacidad) {
+  ReplicaSaldos replica(nombre, 2);
+
+  // La tabla se dimensiona al doble de la capacidad pedida.
+  for (id_billetera id = 1; id <= 4; id++) {
+    EXPECT_TRUE(replica.publicar(id, 100, 0, 1));
+  }
+  EXPECT_EQ(replica.descartadas(), 0);
+  EXPECT_FALSE(replica.publicar(5, 100, 0, 1));
+  EXPECT_TRUE(replica.publicar(1, 50, 0, 2));
+
+  LectorReplicaSaldos lector(nombre);
+  EXPECT_EQ(replica.descartadas(), 1);
+  EXPECT_EQ(lector.descartadas(), 1);
+}
+
+TEST_F(test_replica_saldos, la_blockchain_cuenta_lo_que_no_entra_en_la_replica) {
+  ReplicaSaldos replica(nombre, 1);
+  Blockchain blockchain;
+  blockchain.publicar_saldos_en(&replica);
+
+  for (int i = 0; i < 3; i++) {
+    blockchain.abrir_billetera();
+  }
+
+  // Entran 2 billeteras; la semilla de la tercera se descarta.
+  LectorReplicaSaldos lector(nombre);
+  EXPECT_EQ(lector.descartadas(), 1);
+}
+
+TEST_F(test_replica_saldos, la_blockchain_publica_cada_transaccion) {
+  ReplicaSaldos replica(nombre, 10);
+  LectorReplicaSaldos lector(nombre);
+
+  Blockchain blockchain;
+  blockchain.publicar_saldos_en(&replica);
+  Calendario::fijar(1000);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  Calendario::avanzar_un_minuto();
+  agregar_transaccion(blockchain, billetera1, billetera2, 30);
+
+  LectorReplicaSaldos::Entrada entrada;
+  EXPECT_TRUE(lector.consultar(billetera1->id(), entrada));
+  EXPECT_EQ(entrada.saldo, 70);
+  EXPECT_EQ(entrada.ultima_transaccion, 1060);
+  EXPECT_EQ(entrada.cantidad_transacciones, 2);
+
+  EXPECT_TRUE(lector.consultar(billetera2->id(), entrada));
+  EXPECT_EQ(entrada.saldo, 130);
+}
+
+TEST_F(test_replica_saldos, las_lecturas_concurrentes_son_consistentes) {
+  ReplicaSaldos replica(nombre, 10);
+  LectorReplicaSaldos lector(nombre);
+  replica.publicar(3, 0, 0, 0);
+
+  // El escritor mantiene saldo == cantidad_transacciones; un lector nunca
+  // debería ver una mezcla de dos publicaciones.
+  thread escritor([&replica]() {
+    for (unsigned i = 1; i <= 20000; i++) {
+      replica.publicar(3, i, i, i);
+    }
+  });
+
+  LectorReplicaSaldos::Entrada entrada;
+  for (int i = 0; i < 20000; i++) {
+    ASSERT_TRUE(lector.consultar(3, entrada));
+    ASSERT_EQ(entrada.saldo, entrada.cantidad_transacciones);
+    ASSERT_EQ(entrada.saldo, entrada.ultima_transaccion);
+  }
+  escritor.join();
+}
+
+TEST_F(test_replica_saldos, la_blockchain_fragmentada_publica_desde_todos_los_fragmentos) {
+  ReplicaSaldos replica(nombre, 10);
+  LectorReplicaSaldos lector(nombre);
+
+  BlockchainFragmentada blockchain(2);
+  blockchain.publicar_saldos_en(&replica);
+
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+  EXPECT_TRUE(blockchain.agregar_transaccion(billetera1, billetera2->id(), 40));
+  blockchain.sincronizar();
+
+  LectorReplicaSaldos::Entrada entrada;
+  EXPECT_TRUE(lector.consultar(billetera1->id(), entrada));
+  EXPECT_EQ(entrada.saldo, 60);
+  EXPECT_TRUE(lector.consultar(billetera2->id(), entrada));
+  EXPECT_EQ(entrada.saldo, 140);
+}
@@ -0,0 +1,139 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include "../lib.h"
+#include "../billetera.h"
+#include "../blockchain.h"
+#include "../calendario.h"
+#include "../traza.h"
+#include "tests_lib.h"
+
+using namespace std;
+
+class test_traza : public ::testing::Test {
+protected:
+    string ruta;
+
+    void SetUp() override {
+      Calendario::restaurar();
+      ruta = "traza_" + to_string(getpid()) + ".json";
+      remove(ruta.c_str());
+    }
+
+    void TearDown() override {
+      Traza::desactivar();
+      Calendario::restaurar();
+      remove(ruta.c_str());
+    }
+
+    string leer_volcado() {
+      EXPECT_TRUE(Traza::volcar(ruta));
+      ifstream archivo(ruta);
+      stringstream contenido;
+      contenido << archivo.rdbuf();
+      return contenido.str();
+    }
+};
+
+TEST_F(test_traza, desactivada_no_registra_tramos) {
+  size_t antes = Traza::eventos_guardados();
+  {
+    TramoTraza tramo("inactivo");
+    tramo.argumento("valor", 1);
+  }
+  EXPECT_EQ(Traza::eventos_guardados(), antes);
+}
+
+TEST_F(test_traza, registra_las_transacciones_y_sus_pasos) {
+  Blockchain blockchain;
+  Calendario::fijar(Calendario::dia(1));
+  Billetera* billetera1 = blockchain.abrir_billetera();
+  Billetera* billetera2 = blockchain.abrir_billetera();
+
+  Traza::activar();
+  // Una billetera que estuvo 30 días inactiva completa esos días en su árbol.
+  for (int i = 0; i < 30; i++) {
+    Calendario::avanzar_un_dia();
+  }
+  agregar_transaccion(blockchain, billetera1, billetera2, 10);
+  Traza::desactivar();
+
+  string volcado = leer_volcado();
+  EXPECT_EQ(volcado.find("{\"traceEvents\":["), 0);
+  EXPECT_NE(volcado.find("\"name\":\"agregar_transaccion\""), string::npos);
+  EXPECT_NE(volcado.find("\"origen\":" + to_string(billetera1->id()) + ",\"destino\":" + to_string(billetera2->id())), string::npos);
+  EXPECT_NE(volcado.find("\"name\":\"calcular_saldo\""), string::npos);
+  EXPECT_NE(volcado.find("\"billetera\":" + to_string(billetera2->id())), string::npos);
+  EXPECT_NE(volcado.find("\"dias_agregados\":30"), string::npos);
+  EXPECT_NE(volcado.find("\"name\":\"destinatarios\""), string::npos);
+  EXPECT_NE(volcado.find("\"name\":\"ventana\""), string::npos);
+}
+
+TEST_F(test_traza, cada_hilo_guarda_sus_ultimos_tramos) {
+  Traza::activar(4);
+  size_t antes = Traza::eventos_guardados();
+
+  // El buffer de un hilo nuevo se crea con la capacidad pedida, y al
+  // llenarse se pisan los tramos más viejos.
+  thread hilo([]() {
+    for (int i = 0; i < 10; i++) {
+      TramoTraza tramo("paso");
+      tramo.argumento("i", i);
+    }
+  });
+  hilo.join();
+  Traza::desactivar();
+
+  EXPECT_EQ(Traza::eventos_guardados(), antes + 4);
+  string volcado = leer_volcado();
+  EXPECT_EQ(volcado.find("\"i\":5}"), string::npos);
+  for (int i = 6; i < 10; i++) {
+    EXPECT_NE(volcado.find("\"i\":" + to_string(i) + "}"), string::npos);
+  }
+
+  // Restauramos la capacidad por defecto para los hilos que vengan; TearDown
+  // vuelve a desactivarla.
+  Traza::activar();
+}
+
+TEST_F(test_traza, vuelca_los_tiempos_con_resolucion_de_nanosegundos) {
+  Traza::activar();
+
+  // El tramo tiene que empezar pasado el primer segundo desde el inicio del
+  // proceso, cuando el inicio en microsegundos ya tiene 7 dígitos enteros.
+  string volcado;
+  size_t posicion = string::npos;
+  double inicio_us = 0;
+  for (int intento = 0; intento < 2 && inicio_us < 1e6; intento++) {
+    if (intento > 0) {
+      this_thread::sleep_for(chrono::microseconds(static_cast<long long>(1e6 - inicio_us) + 1000));
+    }
+    {
+      TramoTraza tramo("tardio");
+    }
+    volcado = leer_volcado();
+    posicion = volcado.rfind("\"name\":\"tardio\"");
+    ASSERT_NE(posicion, string::npos);
+    inicio_us = stod(volcado.substr(volcado.find("\"ts\":", posicion) + 5));
+  }
+  Traza::desactivar();
+  ASSERT_GE(inicio_us, 1e6);
+
+  // Parte entera y exactamente 3 decimales, sin notación científica.
+  string evento = volcado.substr(posicion, volcado.find('}', posicion) - posicion);
+  for (const string campo : {"\"ts\":", "\"dur\":"}) {
+    size_t desde = evento.find(campo) + campo.size();
+    string valor = evento.substr(desde, evento.find(',', desde) - desde);
+    size_t punto = valor.find('.');
+    ASSERT_NE(punto, string::npos) << valor;
+    EXPECT_EQ(valor.size() - punto, 4) << valor;
+    EXPECT_EQ(valor.find_first_not_of("0123456789."), string::npos) << valor;
+  }
+}
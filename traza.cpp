@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+#include "traza.h"
+
+using namespace std;
+
+atomic<bool> Traza::_activa(false);
+atomic<size_t> Traza::_eventos_por_hilo(Traza::EVENTOS_POR_HILO);
+const chrono::steady_clock::time_point Traza::_origen = chrono::steady_clock::now();
+mutex Traza::_mutex_buffers;
+vector<unique_ptr<Traza::Buffer>> Traza::_buffers;
+
+void Traza::activar(size_t eventos_por_hilo) {
+  _eventos_por_hilo.store(max<size_t>(1, eventos_por_hilo), memory_order_relaxed);
+  _activa.store(true, memory_order_relaxed);
+}
+
+void Traza::desactivar() {
+  _activa.store(false, memory_order_relaxed);
+}
+
+size_t Traza::eventos_guardados() {
+  lock_guard<mutex> lock(_mutex_buffers);
+
+  size_t total = 0;
+  for (auto it = _buffers.begin(); it != _buffers.end(); ++it) {
+    uint64_t escritos = (*it)->escritos.load(memory_order_acquire);
+    total += min<uint64_t>(escritos, (*it)->eventos.size());
+  }
+  return total;
+}
+
+bool Traza::volcar(const string& ruta) {
+  ofstream archivo(ruta);
+  if (!archivo) {
+    return false;
+  }
+
+  lock_guard<mutex> lock(_mutex_buffers);
+
+  // Microsegundos con los nanosegundos como decimales: la precisión por
+  // defecto (6 dígitos significativos) pierde resolución pasado el segundo.
+  archivo << fixed << setprecision(3);
+  archivo << "{\"traceEvents\":[";
+  bool primero = true;
+  for (auto it = _buffers.begin(); it != _buffers.end(); ++it) {
+    const Buffer& buffer = **it;
+    uint64_t escritos = buffer.escritos.load(memory_order_acquire);
+    uint64_t capacidad = buffer.eventos.size();
+
+    // Del más viejo que sigue en el buffer al más nuevo.
+    for (uint64_t i = escritos > capacidad ? escritos - capacidad : 0; i < escritos; i++) {
+      const Evento& evento = buffer.eventos[i % capacidad];
+
+      archivo << (primero ? "\n" : ",\n");
+      primero = false;
+      // Chrome trace usa microsegundos; "X" es un tramo completo (inicio y
+      // duración).
+      archivo << "{\"name\":\"" << evento.nombre << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.hilo
+              << ",\"ts\":" << evento.inicio_ns / 1000.0 << ",\"dur\":" << evento.duracion_ns / 1000.0
+              << ",\"args\":{";
+      for (size_t a = 0; a < evento.cantidad_argumentos; a++) {
+        archivo << (a > 0 ? "," : "") << "\"" << evento.claves[a] << "\":" << evento.valores[a];
+      }
+      archivo << "}}";
+    }
+  }
+  archivo << "\n]}\n";
+
+  return static_cast<bool>(archivo);
+}
+
+
+/** Métodos privados auxiliares */
+
+uint64_t Traza::_ahora_ns() {
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - _origen).count();
+}
+
+Traza::Buffer* Traza::_buffer_del_hilo() {
+  thread_local Buffer* buffer = nullptr;
+  if (buffer != nullptr) {
+    return buffer;
+  }
+
+  // Primera vez que el hilo registra un tramo: el buffer queda en la lista
+  // global, así sus tramos se pueden volcar aunque el hilo termine.
+  lock_guard<mutex> lock(_mutex_buffers);
+  unique_ptr<Buffer> nuevo(new Buffer());
+  nuevo->eventos.resize(_eventos_por_hilo.load(memory_order_relaxed));
+  nuevo->escritos.store(0, memory_order_relaxed);
+  nuevo->hilo = static_cast<unsigned>(_buffers.size()) + 1;
+  buffer = nuevo.get();
+  _buffers.push_back(move(nuevo));
+  return buffer;
+}
+
+void Traza::_registrar(const Evento& evento) {
+  Buffer* buffer = _buffer_del_hilo();
+
+  // Sólo este hilo escribe `escritos`, así que alcanza con leerlo relajado.
+  uint64_t escritos = buffer->escritos.load(memory_order_relaxed);
+  buffer->eventos[escritos % buffer->eventos.size()] = evento;
+  buffer->escritos.store(escritos + 1, memory_order_release);
+}
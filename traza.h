@@ -0,0 +1,152 @@
+#ifndef TRAZA_H_
+#define TRAZA_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class TramoTraza;
+
+/**
+ * Registro opcional de tramos (intervalos con nombre) para ver en una línea
+ * de tiempo dónde se va el tiempo de cada operación.
+ *
+ * Cada hilo escribe sus tramos en su propio buffer circular, sin locks: al
+ * llenarse, los tramos nuevos pisan a los más viejos. `volcar` los escribe
+ * en el formato JSON de Chrome trace, que abren chrome://tracing y Perfetto.
+ *
+ * Desactivada, cada tramo cuesta una lectura atómica. Activada, dos lecturas
+ * del reloj y la escritura de un evento en el buffer del hilo.
+ */
+class Traza {
+  public:
+    /** Capacidad por defecto del buffer de cada hilo, en tramos. */
+    static const size_t EVENTOS_POR_HILO = 1 << 16;
+
+    /**
+     * Empieza a registrar tramos. Los buffers de los hilos que todavía no
+     * registraron ningún tramo se crean con `eventos_por_hilo` lugares; los
+     * que ya existen conservan su capacidad y su contenido.
+     */
+    static void activar(size_t eventos_por_hilo = EVENTOS_POR_HILO);
+
+    /** Deja de registrar tramos. Lo registrado se conserva. */
+    static void desactivar();
+
+    static bool activa() {
+      return _activa.load(memory_order_relaxed);
+    }
+
+    /**
+     * Cantidad de tramos guardados en los buffers de todos los hilos (los que
+     * escribiría `volcar`).
+     */
+    static size_t eventos_guardados();
+
+    /**
+     * Escribe los tramos guardados en `ruta`, en formato JSON de Chrome
+     * trace. Devuelve `false` si no pudo escribir el archivo.
+     *
+     * Se puede llamar mientras otros hilos registran tramos, pero los tramos
+     * que se pisen durante el volcado pueden salir mezclados: conviene volcar
+     * con la carga detenida.
+     */
+    static bool volcar(const string& ruta);
+
+  private:
+    friend class TramoTraza;
+
+    static const size_t MAXIMO_ARGUMENTOS = 2;
+
+    struct Evento {
+      const char* nombre;
+      uint64_t inicio_ns;
+      uint64_t duracion_ns;
+      size_t cantidad_argumentos;
+      const char* claves[MAXIMO_ARGUMENTOS];
+      uint64_t valores[MAXIMO_ARGUMENTOS];
+    };
+
+    /**
+     * Buffer circular de un hilo. Sólo lo escribe su hilo; `escritos` se
+     * publica con release para que quien vuelca vea los eventos completos.
+     */
+    struct Buffer {
+      vector<Evento> eventos;
+      atomic<uint64_t> escritos;
+      unsigned hilo;
+    };
+
+    static atomic<bool> _activa;
+
+    /** Capacidad de los buffers nuevos. */
+    static atomic<size_t> _eventos_por_hilo;
+
+    /** Momento que se toma como 0 en el JSON. */
+    static const chrono::steady_clock::time_point _origen;
+
+    /** Buffers de todos los hilos, incluso los que ya terminaron. */
+    static mutex _mutex_buffers;
+    static vector<unique_ptr<Buffer>> _buffers;
+
+    /** Métodos auxiliares */
+
+    static uint64_t _ahora_ns();
+
+    static Buffer* _buffer_del_hilo();
+
+    static void _registrar(const Evento& evento);
+};
+
+/**
+ * Tramo de traza con duración igual a la vida del objeto: empieza al
+ * construirse y se registra al destruirse. Si la traza no está activa al
+ * construirse, no registra nada.
+ *
+ * El nombre y las claves de los argumentos no se copian: tienen que ser
+ * literales (o vivir hasta el volcado).
+ */
+class TramoTraza {
+  public:
+    explicit TramoTraza(const char* nombre) {
+      _evento.nombre = Traza::activa() ? nombre : nullptr;
+      _evento.cantidad_argumentos = 0;
+      if (_evento.nombre != nullptr) {
+        _evento.inicio_ns = Traza::_ahora_ns();
+      }
+    }
+
+    /**
+     * Agrega un argumento numérico al tramo. Se guardan a lo sumo dos; los
+     * siguientes se ignoran.
+     */
+    void argumento(const char* clave, uint64_t valor) {
+      if (_evento.nombre == nullptr || _evento.cantidad_argumentos == Traza::MAXIMO_ARGUMENTOS) {
+        return;
+      }
+      _evento.claves[_evento.cantidad_argumentos] = clave;
+      _evento.valores[_evento.cantidad_argumentos] = valor;
+      _evento.cantidad_argumentos++;
+    }
+
+    ~TramoTraza() {
+      if (_evento.nombre != nullptr) {
+        _evento.duracion_ns = Traza::_ahora_ns() - _evento.inicio_ns;
+        Traza::_registrar(_evento);
+      }
+    }
+
+    TramoTraza(const TramoTraza&) = delete;
+    TramoTraza& operator=(const TramoTraza&) = delete;
+
+  private:
+    Traza::Evento _evento;
+};
+
+#endif // TRAZA_H_